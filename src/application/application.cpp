@@ -1,8 +1,115 @@
 #include "application.h"
+#include "parallel_for.h"
+
+#include <algorithm>
 
 namespace application {
 
-Application::Application(model::Game &game, postgres::Database& db, bool random_spawn)
+namespace {
+
+PlayerState MakePlayerState(const model::Dog& dog) {
+    PlayerState state;
+
+    state.dog_id_ = std::to_string(*dog.GetDogId());
+    state.name_ = dog.GetName();
+
+    std::string dir = std::string{ dog.GetDirection() };
+    state.dog_direction_ = dir == "S" ? "" : dir;
+
+    auto pos = dog.GetPosition();
+    state.position_x_ = pos.x;
+    state.position_y_ = pos.y;
+
+    auto speed = dog.GetSpeed();
+    state.horizontal_speed_ = speed.horizontal;
+    state.vertical_speed_ = speed.vertical;
+
+    state.bag_ = dog.GetBag().GetObjects();
+    state.score_ = dog.GetScore();
+    state.changed_tick_ = dog.GetChangedTick();
+
+    return state;
+}
+
+SessionSnapshotPtr MakeSessionSnapshot(const model::GameSession& session) {
+    auto snapshot = std::make_shared<SessionSnapshot>();
+
+    snapshot->session_id_ = session.GetId();
+    snapshot->map_id_ = session.GetMapId();
+
+    for (const auto& dog : session.GetDogs()) {
+        snapshot->player_index_.emplace(*dog->GetDogId(), snapshot->players_state_.size());
+        snapshot->players_state_.push_back(MakePlayerState(*dog));
+    }
+
+    auto loot = session.GetLootStates();
+    snapshot->loots_state_.assign(loot.begin(), loot.end());
+
+    auto spawn_ticks = session.GetLootSpawnTicks();
+    snapshot->loot_spawn_ticks_.assign(spawn_ticks.begin(), spawn_ticks.end());
+
+    snapshot->tick_ = session.GetTick();
+    snapshot->history_start_tick_ = session.GetHistoryStartTick();
+    snapshot->removals_.assign(session.GetRemovals().begin(), session.GetRemovals().end());
+
+    return snapshot;
+}
+
+bool SessionIdLess(const SessionSnapshotPtr& lhs, model::GameSession::Id session_id) {
+    return lhs->session_id_ < session_id;
+}
+
+}  // namespace
+
+SessionSnapshotPtr WorldSnapshot::FindSession(model::GameSession::Id session_id) const {
+    auto it = std::lower_bound(sessions_.begin(), sessions_.end(), session_id, SessionIdLess);
+    if (it != sessions_.end() && (*it)->session_id_ == session_id) {
+        return *it;
+    }
+    return nullptr;
+}
+
+const model::PointGrid& SessionSnapshot::GetPlayersGrid() const {
+    std::call_once(grids_once_, [this] { BuildGrids(); });
+    return players_grid_;
+}
+
+const model::PointGrid& SessionSnapshot::GetLootGrid() const {
+    std::call_once(grids_once_, [this] { BuildGrids(); });
+    return loot_grid_;
+}
+
+void SessionSnapshot::BuildGrids() const {
+    std::vector<geom::Point2D> points;
+
+    points.reserve(players_state_.size());
+    for (const auto& player : players_state_) {
+        points.emplace_back(player.position_x_, player.position_y_);
+    }
+    players_grid_ = model::PointGrid{points};
+
+    points.clear();
+    for (const auto& loot : loots_state_) {
+        points.push_back(loot.position);
+    }
+    loot_grid_ = model::PointGrid{points};
+}
+
+const PlayerState* SessionSnapshot::FindPlayer(std::uint64_t dog_id) const {
+    if (auto it = player_index_.find(dog_id); it != player_index_.end()) {
+        return &players_state_[it->second];
+    }
+    return nullptr;
+}
+
+SessionSnapshot::BodyPtr SessionSnapshot::GetStateBody(const std::function<std::string()>& make) const {
+    std::call_once(state_body_once_, [&] {
+        state_body_ = std::make_shared<const std::string>(make());
+    });
+    return state_body_;
+}
+
+Application::Application(model::Game &game, postgres::IRecordsRepository& db, bool random_spawn)
     : game_(game)
     , random_spawn_(random_spawn)
     , db_(db) {
@@ -19,7 +126,7 @@ const model::Map *Application::FindMap(std::string_view id) {
 AuthResponse Application::JoinToGame(std::string_view user_name, std::string_view map_id) {
 
     auto map_id_t = model::Map::Id(std::string(map_id));
-    model::GameSession* session = game_.GetSession(map_id_t);
+    model::GameSession* session = game_.GetSessionForJoin(map_id_t);
 
     auto dog = std::make_shared<model::Dog>(user_name);
 
@@ -47,20 +154,24 @@ AuthResponse Application::JoinToGame(std::string_view user_name, std::string_vie
 
     auto [player, token] = players_.AddPlayer(dog, session);
 
-    return {*token, dog_id};
+    tokens_.Insert(token, PlayerLocation{session->GetId(), dog_id});
+
+    PublishSnapshot(*session);
+
+    return {token.ToHex(), dog_id};
 }
 
-bool Application::IsAuthorized(std::string_view token) {
-    return players_.IsTokenValid(Token(std::string(token)));
+bool Application::IsAuthorized(const Token& token) const {
+    return tokens_.Contains(token);
 }
 
-void Application::ProcessRetirementPlayers(const std::vector<model::Dog::Id>& ids_to_remove) {
+void Application::ProcessRetirementPlayers(const std::vector<PlayerKey>& players_to_remove) {
 
     std::vector<postgres::PlayerInfo> infos;
 
-    for (const auto& dog_id : ids_to_remove) {
+    for (const auto& [session_id, dog_id] : players_to_remove) {
 
-        auto player = players_.FindByDogId(dog_id);
+        auto player = players_.FindByDogIdAndSessionId(dog_id, session_id);
         
         if (!player)
             continue;
@@ -73,7 +184,10 @@ void Application::ProcessRetirementPlayers(const std::vector<model::Dog::Id>& id
 
         infos.push_back({ name, score, uptime });
 
-        players_.RemovePlayerByDogId(dog_id);
+        if (auto token = players_.FindToken(dog_id, session_id)) {
+            tokens_.Erase(*token);
+        }
+        players_.RemovePlayer(dog_id, session_id);
     }
 
     if (!infos.empty()) {
@@ -81,72 +195,130 @@ void Application::ProcessRetirementPlayers(const std::vector<model::Dog::Id>& id
     }
 }
 
-void Application::Move(const std::string_view token, char direction)
+void Application::Move(const Token& token, char direction)
 {
-    auto player = players_.FindByToken(Token{ std::string(token) });
+    auto player = players_.FindByToken(token);
     auto dog = player->GetDog();
 
     dog->Move(model::Direction(direction));
-}
 
-void Application::UpdateGameState(const std::chrono::milliseconds time_delta) {
+    // Новое направление видно в /game/state сразу, не дожидаясь тика
+    PublishSnapshot(*player->GetSession());
+}
 
-    std::vector<model::Dog::Id> all_ids_to_remove;
+void Application::PublishSnapshot(const model::GameSession& session) {
+    auto current = world_snapshot_.load();
+    auto world = std::make_shared<WorldSnapshot>(*current);
 
-    for (auto& session : game_.GetSessions()) {
-        auto sessions_ids_to_remove = session.second.UpdateGameState(time_delta.count());
+    auto snapshot = MakeSessionSnapshot(session);
+    auto it = std::lower_bound(world->sessions_.begin(), world->sessions_.end(), snapshot->session_id_, SessionIdLess);
 
-        std::transform(sessions_ids_to_remove.begin(), sessions_ids_to_remove.end(), 
-            std::back_inserter(all_ids_to_remove), [](auto id) { return id; });
+    if (it != world->sessions_.end() && (*it)->session_id_ == snapshot->session_id_) {
+        *it = std::move(snapshot);
+    }
+    else {
+        world->sessions_.insert(it, std::move(snapshot));
     }
 
-    ProcessRetirementPlayers(all_ids_to_remove);
+    world_snapshot_.store(std::move(world));
+}
 
-    if (update_listener_) {
-        update_listener_->OnUpdate(time_delta);
+void Application::PublishSnapshots() {
+    tokens_.Clear();
+    players_.ForEachPlayerWithToken([this](const Token& token, const Player& player) {
+        tokens_.Insert(token, PlayerLocation{player.GetSession().GetId(), *player.GetDog()->GetDogId()});
+    });
+
+    auto world = std::make_shared<WorldSnapshot>();
+
+    for (auto& [session_id, session] : game_.GetSessions()) {
+        world->sessions_.push_back(MakeSessionSnapshot(session));
     }
+    std::sort(world->sessions_.begin(), world->sessions_.end(), [](const auto& lhs, const auto& rhs) {
+        return lhs->session_id_ < rhs->session_id_;
+    });
+
+    world_snapshot_.store(std::move(world));
 }
 
-std::vector<Player>& Application::GetAllPlayers() {
-    return players_.GetPlayers(); 
+void Application::SetTickThreads(unsigned threads) {
+    if (threads < 2) {
+        tick_pool_.reset();
+        return;
+    }
+    tick_pool_ = std::make_unique<boost::asio::thread_pool>(threads);
 }
 
-GameState Application::GetState(std::string_view token)
-{
-    GameState states;
+void Application::UpdateGameState(const std::chrono::milliseconds time_delta) {
 
-    for (auto& player : GetAllPlayers()) {
-        PlayerState state;
+    // Сессии упорядочены по id, чтобы порядок удаления игроков не зависел
+    // от порядка обхода unordered_map и от того, какой поток закончил первым
+    std::vector<model::GameSession*> sessions;
+    for (auto& [session_id, session] : game_.GetSessions()) {
+        sessions.push_back(&session);
+    }
+    std::sort(sessions.begin(), sessions.end(), [](const auto* lhs, const auto* rhs) {
+        return lhs->GetId() < rhs->GetId();
+    });
+
+    std::vector<std::vector<model::Dog::Id>> sessions_ids_to_remove(sessions.size());
+    auto world = std::make_shared<WorldSnapshot>();
+    world->sessions_.resize(sessions.size());
+
+    auto update_session = [&](size_t i) {
+        sessions_ids_to_remove[i] = sessions[i]->UpdateGameState(time_delta.count());
+        world->sessions_[i] = MakeSessionSnapshot(*sessions[i]);
+    };
+
+    if (!tick_pool_ || sessions.size() < 2) {
+        for (size_t i = 0; i < sessions.size(); ++i) {
+            update_session(i);
+        }
+    }
+    else {
+        // Сессии не разделяют состояние, поэтому каждая обновляется в своей задаче
+        ParallelFor(*tick_pool_, sessions.size(), update_session);
+    }
 
-        auto dog = player.GetDog();
-        state.dog_id_ = std::to_string(*dog->GetDogId());
+    std::vector<PlayerKey> players_to_remove;
 
-        std::string dir = std::string{ dog->GetDirection() };
-        state.dog_direction_ = dir == "S" ? "" : dir;
+    for (size_t i = 0; i < sessions.size(); ++i) {
+        for (const auto& dog_id : sessions_ids_to_remove[i]) {
+            players_to_remove.push_back({sessions[i]->GetId(), dog_id});
+        }
+    }
 
-        auto pos = dog->GetPosition();
-        state.position_x_ = pos.x;
-        state.position_y_ = pos.y;
+    ProcessRetirementPlayers(players_to_remove);
 
-        auto speed = dog->GetSpeed();
-        state.horizontal_speed_ = speed.horizontal;
-        state.vertical_speed_ = speed.vertical;
+    // Опустевшие сессии удаляются вместе со своими снимками
+    auto removed_sessions = game_.RemoveEmptySessions();
+    std::erase_if(world->sessions_, [&removed_sessions](const SessionSnapshotPtr& snapshot) {
+        return std::find(removed_sessions.begin(), removed_sessions.end(), snapshot->session_id_) != removed_sessions.end();
+    });
 
-        state.bag_ = dog->GetBag().GetObjects();
-        state.score_ = dog->GetScore();
+    // Сессии уже упорядочены по id
+    world_snapshot_.store(std::move(world));
 
-        states.players_state_.push_back(state);
+    for (const auto& listener : update_listeners_) {
+        listener->OnUpdate(time_delta);
     }
+}
+
 
-    auto player = players_.FindByToken(Token(std::string(token)));
-    
-    if (player) {
-        auto loot = player->GetSession()->GetLootStates();
-        states.loots_state_ = std::move(loot);
+GameState Application::GetState(const Token& token) const
+{
+    GameState state{ world_snapshot_.load() };
+
+    if (auto location = tokens_.Find(token)) {
+        state.session_ = state.world_->FindSession(location->session_id);
+        if (state.session_) {
+            state.player_ = state.session_->FindPlayer(location->dog_id);
+        }
     }
 
-    return states;
+    return state;
 }
+
 RecordsInfo Application::GetRecordsInfo(std::optional<int> start, std::optional<int> maxItems)
 {
     auto records = db_.GetRecords(start, maxItems);
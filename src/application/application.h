@@ -1,11 +1,19 @@
 #pragma once
 
 #include "model.h"
+#include "point_grid.h"
 #include "player.h"
+#include "token_map.h"
 #include "application_listener.h"
-#include "postgres.h"
+#include "records_repository.h"
 
+#include <boost/asio/thread_pool.hpp>
+
+#include <atomic>
 #include <chrono>
+#include <functional>
+#include <memory>
+#include <mutex>
 
 namespace application {
 
@@ -17,6 +25,7 @@ using UpdateListener = std::shared_ptr<IApplicationlListener>;
 
 struct PlayerState {
     std::string dog_id_;
+    std::string name_;
     std::string dog_direction_;
     float horizontal_speed_;
     float vertical_speed_;
@@ -24,13 +33,76 @@ struct PlayerState {
     float position_y_;
     uint64_t score_;
     model::LootStates bag_;
+    std::uint64_t changed_tick_ = 0;
 };
 
 using PlayersState = std::vector<PlayerState>;
 
-struct GameState {
+// Неизменяемое состояние игровой сессии.
+// Публикуется после каждого изменения сессии, читатели только берут указатель на него
+struct SessionSnapshot {
+    using BodyPtr = std::shared_ptr<const std::string>;
+
+    // Возвращает тело полного ответа о состоянии сессии.
+    // Тело строится функцией make один раз, остальные запросы получают ту же строку
+    BodyPtr GetStateBody(const std::function<std::string()>& make) const;
+
+    // Индексы собак и трофеев по координатам, строятся первым запросом с областью видимости
+    const model::PointGrid& GetPlayersGrid() const;
+    const model::PointGrid& GetLootGrid() const;
+
+    // Состояние собаки dog_id или nullptr
+    const PlayerState* FindPlayer(std::uint64_t dog_id) const;
+
+    model::GameSession::Id session_id_{0};
+    model::Map::Id map_id_{""};
     PlayersState players_state_;
     model::LootStates loots_state_;
+    // loot_spawn_ticks_[i] - тик появления трофея loots_state_[i]
+    std::vector<std::uint64_t> loot_spawn_ticks_;
+
+    std::uint64_t tick_ = 0;
+    std::uint64_t history_start_tick_ = 0;
+    std::vector<model::TickRemovals> removals_;
+    // id собаки -> индекс в players_state_
+    std::unordered_map<std::uint64_t, size_t> player_index_;
+
+private:
+    void BuildGrids() const;
+
+    mutable std::once_flag state_body_once_;
+    mutable BodyPtr state_body_;
+
+    mutable std::once_flag grids_once_;
+    mutable model::PointGrid players_grid_;
+    mutable model::PointGrid loot_grid_;
+};
+
+using SessionSnapshotPtr = std::shared_ptr<const SessionSnapshot>;
+
+struct PlayerLocation {
+    model::GameSession::Id session_id;
+    std::uint64_t dog_id;
+};
+
+// Токен игрока -> его сессия и собака
+using TokenIndex = TokenMap<PlayerLocation>;
+
+struct WorldSnapshot {
+    SessionSnapshotPtr FindSession(model::GameSession::Id session_id) const;
+
+    // Упорядочены по id сессии
+    std::vector<SessionSnapshotPtr> sessions_;
+};
+
+using WorldSnapshotPtr = std::shared_ptr<const WorldSnapshot>;
+
+struct GameState {
+    WorldSnapshotPtr world_;
+    // Сессия игрока, nullptr для неизвестного токена
+    SessionSnapshotPtr session_;
+    // Собака игрока в session_
+    const PlayerState* player_ = nullptr;
 };
 
 using RecordsInfo = std::vector<std::tuple<std::string, int, double>>;
@@ -40,19 +112,23 @@ class Application {
 
 public:
 
-    Application(model::Game& game, postgres::Database& db, bool random_spawn);
+    Application(model::Game& game, postgres::IRecordsRepository& db, bool random_spawn);
 
     const model::Game::Maps& GetMaps();
     const model::Map* FindMap(std::string_view id);
     AuthResponse JoinToGame(std::string_view user_name, std::string_view map_id);
-    std::vector<Player>& GetAllPlayers();
-    GameState GetState(std::string_view token);
+    // Состояние сессии игрока. Можно вызывать из любого потока
+    GameState GetState(const Token& token) const;
     RecordsInfo GetRecordsInfo(std::optional<int> start, std::optional<int> maxItems);
-    void Move(const std::string_view token, char direction);
+    void Move(const Token& token, char direction);
     void UpdateGameState(const std::chrono::milliseconds time_delta);
-    bool IsAuthorized(std::string_view token);
+    // Проверяет токен, можно вызывать из любого потока
+    bool IsAuthorized(const Token& token) const;
+    // Последний опубликованный снимок мира, можно вызывать из любого потока
+    WorldSnapshotPtr GetWorldSnapshot() const { return world_snapshot_.load(); }
 
-    void SetUpdateListener(UpdateListener listener) { update_listener_ = listener; }
+    // Слушатели вызываются в api strand после каждого обновления игры, в порядке добавления
+    void AddUpdateListener(UpdateListener listener) { update_listeners_.push_back(std::move(listener)); }
 
     model::Game& GetGame() { return game_; }
     Players& GetPlayers() { return players_; }
@@ -61,16 +137,30 @@ public:
     void SetRandomSpawn(bool random_spawn) { random_spawn_ = random_spawn; }
     bool GetRandomSpawn() { return random_spawn_; }
 
+    // Количество потоков, в которых параллельно обновляются игровые сессии.
+    // При значении меньше 2 сессии обновляются в вызывающем потоке
+    void SetTickThreads(unsigned threads);
+
+    // Заново публикует состояние всех сессий, например после восстановления игры
+    void PublishSnapshots();
+
 private:
 
-    void ProcessRetirementPlayers(const std::vector<model::Dog::Id>& ids_to_remove);    
+    void ProcessRetirementPlayers(const std::vector<PlayerKey>& players_to_remove);
+    // Перестраивает снимок одной сессии, остальные сессии мира переиспользуются по указателю
+    void PublishSnapshot(const model::GameSession& session);
 
 private:
     model::Game& game_;
     Players players_;
     bool random_spawn_ = false;
-    UpdateListener update_listener_;
-    postgres::Database& db_;
+    std::vector<UpdateListener> update_listeners_;
+    // Меняется в api strand по одному токену, читается из любого потока
+    TokenIndex tokens_;
+    postgres::IRecordsRepository& db_;
+    std::unique_ptr<boost::asio::thread_pool> tick_pool_;
+    // Публикуется в api strand, читается из любого потока
+    std::atomic<WorldSnapshotPtr> world_snapshot_{std::make_shared<const WorldSnapshot>()};
 };
 
 }
\ No newline at end of file
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <boost/asio/post.hpp>
+#include <boost/asio/thread_pool.hpp>
+
+#include <cstddef>
+#include <exception>
+#include <latch>
+#include <vector>
+
+namespace application {
+
+/*
+ *  Вызывает fn(i) для каждого i из [0, count) в потоках пула pool и ждёт завершения всех вызовов.
+ *  Исключение из вызова не прерывает остальные: после завершения всех вызовов
+ *  пробрасывается исключение вызова с наименьшим i.
+ */
+template <typename Fn>
+void ParallelFor(boost::asio::thread_pool& pool, size_t count, Fn&& fn) {
+    std::latch done(static_cast<std::ptrdiff_t>(count));
+    std::vector<std::exception_ptr> errors(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        boost::asio::post(pool, [&, i] {
+            try {
+                fn(i);
+            } catch (...) {
+                errors[i] = std::current_exception();
+            }
+            done.count_down();
+        });
+    }
+    done.wait();
+
+    for (const auto& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+}
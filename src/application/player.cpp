@@ -14,7 +14,7 @@ std::shared_ptr<model::Dog> Player::GetDog() {
     return dog_;
 }
 
-model::GameSession Player::GetSession() const {
+const model::GameSession& Player::GetSession() const {
     return *session_;
 }
 std::shared_ptr<model::Dog> Player::GetDog() const {
@@ -1,18 +1,16 @@
 #pragma once
 
 #include "model.h"
+#include "token.h"
 
+#include <deque>
+#include <optional>
 #include <random>
-#include <iomanip>
-#include <sstream>
+#include <unordered_map>
+#include <vector>
 
 namespace application {
 
-struct TokenTag {};
-
-using Token = util::Tagged<std::string, TokenTag>;
-using TokenHasher = util::TaggedHasher<Token>;
-
 class Player {
 public:
     Player(model::GameSession* session, std::shared_ptr<model::Dog> dog);
@@ -20,7 +18,7 @@ public:
     model::GameSession* GetSession();
     std::shared_ptr<model::Dog> GetDog();
 
-    model::GameSession GetSession() const;
+    const model::GameSession& GetSession() const;
     std::shared_ptr<model::Dog> GetDog() const;
 
 private:
@@ -28,125 +26,242 @@ private:
     std::shared_ptr<model::Dog> dog_;
 };
 
+// Ключ игрока: id собаки уникален только в пределах своей сессии
+struct PlayerKey {
+    model::GameSession::Id session_id;
+    model::Dog::Id dog_id;
+
+    bool operator==(const PlayerKey&) const = default;
+};
+
+struct PlayerKeyHasher {
+    size_t operator()(const PlayerKey& key) const {
+        const size_t session_hash = std::hash<std::uint64_t>{}(*key.session_id);
+        const size_t dog_hash = std::hash<std::uint64_t>{}(*key.dog_id);
+        return session_hash ^ (dog_hash + 0x9e3779b97f4a7c15ULL + (session_hash << 6) + (session_hash >> 2));
+    }
+};
+
+/*
+ *  Реестр игроков.
+ *  Игроки хранятся в слотах, которые не перемещаются при удалении других игроков,
+ *  поэтому указатели Player* остаются действительными до удаления самого игрока.
+ *  Освободившиеся слоты переиспользуются, номер поколения слота отличает нового
+ *  владельца от удалённого. Поиск по токену и по (карта, id собаки) выполняется
+ *  через хеш-индексы.
+ */
 class Players {
 public:
     Players() = default;
 
     Players& operator=(const Players& other) {
         if (this != &other) {
-            players_ = other.players_;
-            player_id_to_index_ = other.player_id_to_index_;
+            slots_ = other.slots_;
+            free_slots_ = other.free_slots_;
+            token_to_handle_ = other.token_to_handle_;
+            key_to_handle_ = other.key_to_handle_;
+            size_ = other.size_;
         }
         return *this;
-    }    
+    }
 
+    // Токен -> индекс игрока в GetPlayers(). Используется при сериализации
     using PlayerIdToIndex = std::unordered_map<Token, size_t, TokenHasher>;
 
     std::pair<Player*, Token> AddPlayer(std::shared_ptr<model::Dog> dog, model::GameSession* session) {
 
         Token token = GenerateToken();
+        while (token_to_handle_.contains(token)) {
+            token = GenerateToken();
+        }
+
+        Player* player = Emplace(token, Player(session, dog));
+
+        return {player, token};
+    }
 
-        players_.emplace_back(Player(session, dog));
+    bool IsTokenValid(const Token& token) const {
+        return token_to_handle_.contains(token);
+    }
 
-        player_id_to_index_[token] = players_.size() - 1;
+    Player* FindByToken(const Token& token) {
+        const auto index = FindSlot(token_to_handle_, token);
+        return index ? &*slots_[*index].player : nullptr;
+    }
 
-        return {&players_.back(), token};
+    const Player* FindByToken(const Token& token) const {
+        const auto index = FindSlot(token_to_handle_, token);
+        return index ? &*slots_[*index].player : nullptr;
     }
 
-    bool IsTokenValid(Token token) const {
-        return player_id_to_index_.find(token) != player_id_to_index_.end();
+    Player* FindByDogIdAndSessionId(model::Dog::Id dog_id, model::GameSession::Id session_id) {
+        const auto index = FindSlot(key_to_handle_, PlayerKey{session_id, dog_id});
+        return index ? &*slots_[*index].player : nullptr;
     }
 
+    const Player* FindByDogIdAndSessionId(model::Dog::Id dog_id, model::GameSession::Id session_id) const {
+        const auto index = FindSlot(key_to_handle_, PlayerKey{session_id, dog_id});
+        return index ? &*slots_[*index].player : nullptr;
+    }
 
-    Player* FindByToken(Token token) {
-        if (auto it = player_id_to_index_.find(token); it != player_id_to_index_.end()) {
-            return &players_.at(it->second);
+    std::optional<Token> FindToken(model::Dog::Id dog_id, model::GameSession::Id session_id) const {
+        if (const auto index = FindSlot(key_to_handle_, PlayerKey{session_id, dog_id})) {
+            return slots_[*index].token;
         }
-        return nullptr;
+        return std::nullopt;
     }
 
-    std::optional<Player> FindByToken(Token token) const {
-        if (auto it = player_id_to_index_.find(token); it != player_id_to_index_.end()) {
-            return players_.at(it->second);
+    bool RemovePlayer(model::Dog::Id dog_id, model::GameSession::Id session_id) {
+
+        auto it = key_to_handle_.find(PlayerKey{session_id, dog_id});
+        if (it == key_to_handle_.end()) {
+            return false;
         }
 
-        return std::nullopt;
+        const Handle handle = it->second;
+        key_to_handle_.erase(it);
+
+        Slot& slot = slots_[handle.index];
+        token_to_handle_.erase(slot.token);
+        slot.player.reset();
+        ++slot.generation;
+        free_slots_.push_back(handle.index);
+        --size_;
+
+        return true;
     }
 
-    Player* FindByDogIdAndMapId(model::Dog::Id dog_id, model::Map::Id map_id) {
-        for (Player& player : players_) {
-            if (player.GetDog()->GetDogId() == dog_id && player.GetSession()->GetMapId() == map_id) {
-                return &player;
+    size_t Size() const noexcept {
+        return size_;
+    }
+
+    // Обходит игроков в порядке слотов
+    template <typename Fn>
+    void ForEachPlayer(Fn&& fn) {
+        for (auto& slot : slots_) {
+            if (slot.player) {
+                fn(*slot.player);
             }
         }
-        return nullptr;
     }
 
-    std::optional<Player> FindByDogId(const model::Dog::Id& dog_id) const {
-        for (const Player& player : players_) {
-            if (player.GetDog()->GetDogId() == dog_id) {
-                return player;
+    template <typename Fn>
+    void ForEachPlayer(Fn&& fn) const {
+        for (const auto& slot : slots_) {
+            if (slot.player) {
+                fn(*slot.player);
             }
         }
-        return std::nullopt;
     }
 
-    void RemovePlayerByDogId(const model::Dog::Id& dog_id) {
+    template <typename Fn>
+    void ForEachPlayerWithToken(Fn&& fn) const {
+        for (const auto& slot : slots_) {
+            if (slot.player) {
+                fn(slot.token, *slot.player);
+            }
+        }
+    }
 
-        auto it = std::find_if(players_.begin(), players_.end(), [&dog_id](const Player& player) {
-            return player.GetDog()->GetDogId() == dog_id;
+    std::vector<const Player*> GetPlayers() const {
+        std::vector<const Player*> players;
+        players.reserve(size_);
+        ForEachPlayer([&players](const Player& player) {
+            players.push_back(&player);
         });
+        return players;
+    }
 
-        if (it == players_.end()) {
-            return;
+    PlayerIdToIndex GetPlayerIdToIndex() const {
+        PlayerIdToIndex token_to_index;
+        size_t index = 0;
+        for (const auto& slot : slots_) {
+            if (slot.player) {
+                token_to_index.emplace(slot.token, index++);
+            }
         }
+        return token_to_index;
+    }
 
-        auto indexToRemove = std::distance(players_.begin(), it);
-
-        players_.erase(it);
-
-        auto tokenIt = std::find_if(player_id_to_index_.begin(), player_id_to_index_.end(),
-                       [indexToRemove](const auto& pair) { return pair.second == indexToRemove; });                
-
-        if (tokenIt != player_id_to_index_.end()) {
-            player_id_to_index_.erase(tokenIt);
+    // Заменяет всех игроков. token_to_index ссылается на индексы в players
+    void Restore(std::vector<Player> players, const PlayerIdToIndex& token_to_index) {
+        slots_.clear();
+        free_slots_.clear();
+        token_to_handle_.clear();
+        key_to_handle_.clear();
+        size_ = 0;
+
+        std::vector<const Token*> tokens(players.size(), nullptr);
+        for (const auto& [token, index] : token_to_index) {
+            if (index < tokens.size()) {
+                tokens[index] = &token;
+            }
         }
-        
-        for (auto& pair : player_id_to_index_) {
-            if (pair.second > indexToRemove) {
-                pair.second--;
+
+        for (size_t i = 0; i < players.size(); ++i) {
+            if (tokens[i]) {
+                Emplace(*tokens[i], std::move(players[i]));
             }
-        }              
+        }
     }
 
-    std::vector<Player>& GetPlayers() {
-        return players_;
-    }
+private:
+    struct Handle {
+        std::uint32_t index;
+        std::uint32_t generation;
+    };
+
+    struct Slot {
+        std::optional<Player> player;
+        Token token;
+        std::uint32_t generation = 0;
+    };
+
+    Player* Emplace(const Token& token, Player player) {
+
+        std::uint32_t index;
+        if (!free_slots_.empty()) {
+            index = free_slots_.back();
+            free_slots_.pop_back();
+        }
+        else {
+            index = static_cast<std::uint32_t>(slots_.size());
+            slots_.emplace_back();
+        }
 
-    std::vector<Player> GetPlayers() const {
-        return players_;
-    }
+        Slot& slot = slots_[index];
+        slot.player.emplace(std::move(player));
+        slot.token = token;
 
-    void SetPlayers(const std::vector<Player>& players) {
-        players_ = std::move(players);
-    }
+        const Handle handle{index, slot.generation};
+        token_to_handle_.emplace(token, handle);
+        key_to_handle_.emplace(PlayerKey{slot.player->GetSession()->GetId(), slot.player->GetDog()->GetDogId()}, handle);
+        ++size_;
 
-    PlayerIdToIndex GetPlayerIdToIndex() const {
-        return player_id_to_index_;
+        return &*slot.player;
     }
 
-    void SetPlayerIdToIndex(const PlayerIdToIndex& player_id_to_index) {
-        player_id_to_index_ = player_id_to_index;
+    // Индекс слота, в котором живёт игрок с ключом key из хеш-индекса index
+    template <typename Index, typename Key>
+    std::optional<std::uint32_t> FindSlot(const Index& index, const Key& key) const {
+        const auto it = index.find(key);
+        if (it == index.end()) {
+            return std::nullopt;
+        }
+
+        const Handle handle = it->second;
+        const Slot& slot = slots_[handle.index];
+        if (slot.generation != handle.generation || !slot.player) {
+            return std::nullopt;
+        }
+        return handle.index;
     }
 
 private:
 
     Token GenerateToken() {
-        std::stringstream ss;
-        ss << std::hex << std::setw(16) << std::setfill('0') << generator1_();
-        ss << std::setw(16) << std::setfill('0') << generator2_();
-        
-        return Token(ss.str());
+        const auto hi = generator1_();
+        return Token{hi, generator2_()};
     }
 
     std::random_device random_device_;
@@ -159,8 +274,12 @@ private:
         return dist(random_device_);
     }()};
 
-    std::vector<Player> players_;
-    PlayerIdToIndex player_id_to_index_;
+    // deque не перемещает элементы при добавлении в конец
+    std::deque<Slot> slots_;
+    std::vector<std::uint32_t> free_slots_;
+    std::unordered_map<Token, Handle, TokenHasher> token_to_handle_;
+    std::unordered_map<PlayerKey, Handle, PlayerKeyHasher> key_to_handle_;
+    size_t size_ = 0;
 };
 
 }
\ No newline at end of file
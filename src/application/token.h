@@ -0,0 +1,103 @@
+#pragma once
+
+#include <compare>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace application {
+
+/*
+ *  Токен игрока - 128-битное значение.
+ *  Клиенту передаётся как 32 шестнадцатеричных символа в нижнем регистре.
+ *  Кодирование и разбор обходятся без ветвлений по символам и без выделения памяти,
+ *  поэтому проверка токена на каждом запросе ничего не аллоцирует.
+ */
+class Token {
+public:
+    static constexpr size_t HEX_LENGTH = 32;
+
+    constexpr Token() = default;
+    constexpr Token(std::uint64_t hi, std::uint64_t lo) noexcept
+        : hi_(hi)
+        , lo_(lo) {
+    }
+
+    // Разбирает ровно HEX_LENGTH символов 0-9a-f, иначе возвращает nullopt
+    static std::optional<Token> FromHex(std::string_view hex) noexcept {
+        if (hex.size() != HEX_LENGTH) {
+            return std::nullopt;
+        }
+
+        bool valid = true;
+        const auto hi = DecodeHex(hex.substr(0, HEX_LENGTH / 2), valid);
+        const auto lo = DecodeHex(hex.substr(HEX_LENGTH / 2), valid);
+
+        if (!valid) {
+            return std::nullopt;
+        }
+        return Token{hi, lo};
+    }
+
+    // Записывает HEX_LENGTH символов в out
+    void ToHex(char* out) const noexcept {
+        EncodeHex(hi_, out);
+        EncodeHex(lo_, out + HEX_LENGTH / 2);
+    }
+
+    std::string ToHex() const {
+        std::string hex(HEX_LENGTH, '0');
+        ToHex(hex.data());
+        return hex;
+    }
+
+    std::uint64_t GetHi() const noexcept {
+        return hi_;
+    }
+
+    std::uint64_t GetLo() const noexcept {
+        return lo_;
+    }
+
+    auto operator<=>(const Token&) const = default;
+
+private:
+    static std::uint64_t DecodeHex(std::string_view hex, bool& valid) noexcept {
+        std::uint64_t value = 0;
+        bool ok = true;
+
+        for (char c : hex) {
+            const unsigned digit = static_cast<unsigned char>(c) - unsigned{'0'};
+            const unsigned letter = static_cast<unsigned char>(c) - unsigned{'a'};
+            const bool is_digit = digit < 10;
+
+            ok &= is_digit | (letter < 6);
+            value = (value << 4) | (is_digit ? digit : letter + 10);
+        }
+
+        valid &= ok;
+        return value;
+    }
+
+    static void EncodeHex(std::uint64_t value, char* out) noexcept {
+        for (int i = static_cast<int>(HEX_LENGTH / 2) - 1; i >= 0; --i) {
+            const unsigned nibble = value & 0xF;
+            // Для nibble > 9 старший бит (9 - nibble) равен 1 и добавляет 'a' - '0' - 10
+            out[i] = static_cast<char>('0' + nibble + ((9u - nibble) >> 31) * ('a' - '0' - 10));
+            value >>= 4;
+        }
+    }
+
+    std::uint64_t hi_ = 0;
+    std::uint64_t lo_ = 0;
+};
+
+struct TokenHasher {
+    size_t operator()(const Token& token) const noexcept {
+        // Токены случайны, поэтому достаточно перемешать половины
+        return static_cast<size_t>(token.GetHi() ^ (token.GetLo() * 0x9e3779b97f4a7c15ULL));
+    }
+};
+
+}  // namespace application
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "token.h"
+
+#include <array>
+#include <mutex>
+#include <optional>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace application {
+
+/*
+ *  Потокобезопасный словарь токен -> Value.
+ *  Разбит на сегменты со своими shared_mutex: добавление и удаление меняют одну запись
+ *  без копирования словаря, а читатели из разных потоков не мешают друг другу.
+ */
+template <typename Value>
+class TokenMap {
+public:
+    void Insert(const Token& token, Value value) {
+        auto& shard = ShardOf(token);
+        std::unique_lock lock{shard.mutex};
+        shard.values.insert_or_assign(token, std::move(value));
+    }
+
+    bool Erase(const Token& token) {
+        auto& shard = ShardOf(token);
+        std::unique_lock lock{shard.mutex};
+        return shard.values.erase(token) > 0;
+    }
+
+    std::optional<Value> Find(const Token& token) const {
+        const auto& shard = ShardOf(token);
+        std::shared_lock lock{shard.mutex};
+        if (auto it = shard.values.find(token); it != shard.values.end()) {
+            return it->second;
+        }
+        return std::nullopt;
+    }
+
+    bool Contains(const Token& token) const {
+        const auto& shard = ShardOf(token);
+        std::shared_lock lock{shard.mutex};
+        return shard.values.contains(token);
+    }
+
+    void Clear() {
+        for (auto& shard : shards_) {
+            std::unique_lock lock{shard.mutex};
+            shard.values.clear();
+        }
+    }
+
+    size_t Size() const {
+        size_t size = 0;
+        for (const auto& shard : shards_) {
+            std::shared_lock lock{shard.mutex};
+            size += shard.values.size();
+        }
+        return size;
+    }
+
+private:
+    static constexpr size_t SHARDS = 16;
+
+    struct Shard {
+        mutable std::shared_mutex mutex;
+        std::unordered_map<Token, Value, TokenHasher> values;
+    };
+
+    // Токены случайны, поэтому сегмент выбирается по старшим битам
+    Shard& ShardOf(const Token& token) {
+        return shards_[token.GetHi() >> 60];
+    }
+
+    const Shard& ShardOf(const Token& token) const {
+        return shards_[token.GetHi() >> 60];
+    }
+
+    static_assert(SHARDS == 16, "ShardOf takes the top 4 bits of the token");
+
+    std::array<Shard, SHARDS> shards_;
+};
+
+}  // namespace application
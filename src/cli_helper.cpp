@@ -11,6 +11,7 @@ std::optional<Arguments> ParseCommandLine(int argc, const char* const argv[]) {
     po::options_description desc{"Allowed options"};
 
     Arguments args;
+    std::uint64_t random_seed = 0;
 
     desc.add_options()
         ("help,h", "produce help message")
@@ -19,7 +20,12 @@ std::optional<Arguments> ParseCommandLine(int argc, const char* const argv[]) {
         ("www-root,w", po::value(&args.www_root)->value_name("folder path"), "set static files root")
         ("randomize-spawn-points", "spawn dogs at random positions")
         ("state-file,s", po::value(&args.state_file_path)->value_name("save file path"), "set state file path")
-        ("save-state-period,st", po::value(&args.save_state_period)->value_name("milliseconds"), "set state save period");
+        ("save-state-period,st", po::value(&args.save_state_period)->value_name("milliseconds"), "set state save period")
+        ("tick-threads", po::value(&args.tick_threads)->value_name("count"), "set number of threads updating game sessions")
+        ("fixed-tick", "update game state with a constant time step equal to tick period")
+        ("max-catch-up-ticks", po::value(&args.max_catch_up_ticks)->value_name("count"), "set max fixed steps per tick under overload")
+        ("random-seed", po::value(&random_seed)->value_name("seed"), "set seed for dog spawn and loot generation")
+        ("static-cache-size", po::value(&args.static_cache_size)->value_name("megabytes"), "set in-memory static files cache size, 0 disables cache");
 
     po::variables_map vm;
     po::store(po::parse_command_line(argc, argv, desc), vm);
@@ -34,6 +40,14 @@ std::optional<Arguments> ParseCommandLine(int argc, const char* const argv[]) {
        args.randomize_spawn_dog = true;
     }
 
+    if (vm.contains("random-seed"s)) {
+       args.random_seed = random_seed;
+    }
+
+    if (vm.contains("fixed-tick"s)) {
+       args.fixed_tick = true;
+    }
+
     if (!vm.contains("config-file"s)) {
        throw std::runtime_error("Config file have not been specified");
     }
@@ -14,6 +14,11 @@ struct Arguments {
     bool randomize_spawn_dog { false };
     std::string state_file_path;
     std::uint64_t save_state_period {0};
+    unsigned tick_threads {0};
+    bool fixed_tick { false };
+    unsigned max_catch_up_ticks {5};
+    std::optional<std::uint64_t> random_seed;
+    std::size_t static_cache_size {32};
 };
 
 std::optional<Arguments> ParseCommandLine(int argc, const char* const argv[]);
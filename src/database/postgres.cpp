@@ -15,6 +15,7 @@ Database::Database(const std::string& conn)
 }
 
 void Database::AddRecord(const std::string& name, int score, double play_time) {
+	std::lock_guard lock{ mutex_ };
 	pqxx::work w(conn_);
 	w.exec("INSERT INTO retired_players (name, score, time) VALUES (" +
 		w.quote(static_cast<std::string>(name)) + ", " + std::to_string(score) + ", " + std::to_string(play_time) + ")");
@@ -22,6 +23,7 @@ void Database::AddRecord(const std::string& name, int score, double play_time) {
 }
 
 std::vector<PlayerInfo> Database::GetRecords(std::optional<int> start, std::optional<int> maxItems) {
+	std::lock_guard lock{ mutex_ };
 	pqxx::read_transaction r(conn_);
 
 	constexpr size_t default_max = 100;
@@ -43,6 +45,7 @@ std::vector<PlayerInfo> Database::GetRecords(std::optional<int> start, std::opti
 }
 
 void Database::AddRecords(const std::vector<PlayerInfo>& infos) {
+	std::lock_guard lock{ mutex_ };
 	pqxx::work w(conn_);
 
 	for (auto& info : infos) {
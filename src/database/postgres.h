@@ -1,28 +1,27 @@
 #pragma once
 
+#include "records_repository.h"
+
 #include <pqxx/pqxx>
+#include <mutex>
 #include <string>
 
 
 namespace postgres {
 
-struct PlayerInfo {
-	std::string name;
-	int score;
-	double play_time;
-};
-
-class Database {
+class Database : public IRecordsRepository {
 public:
 	explicit Database(const std::string& conn);
 
 	void AddRecord(const std::string& name, int score, double play_time);
 
-	std::vector<PlayerInfo> GetRecords(std::optional<int> start, std::optional<int> maxItems);
+	std::vector<PlayerInfo> GetRecords(std::optional<int> start, std::optional<int> maxItems) override;
 
-	void AddRecords(const std::vector<PlayerInfo>& infos);
+	void AddRecords(const std::vector<PlayerInfo>& infos) override;
 
 private:
+	// Соединение используется и из api strand, и из потоков, читающих рекорды
+	std::mutex mutex_;
 	pqxx::connection conn_;		
 };
 
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace postgres {
+
+struct PlayerInfo {
+	std::string name;
+	int score;
+	double play_time;
+};
+
+// Хранилище рекордов ушедших игроков
+class IRecordsRepository {
+public:
+	virtual void AddRecords(const std::vector<PlayerInfo>& infos) = 0;
+
+	virtual std::vector<PlayerInfo> GetRecords(std::optional<int> start, std::optional<int> maxItems) = 0;
+
+	virtual ~IRecordsRepository() = default;
+};
+
+}
@@ -1,9 +1,129 @@
 #include "http_server.h"
 
 #include <boost/asio/dispatch.hpp>
+#include <boost/asio/steady_timer.hpp>
+
+#ifdef __linux__
+#include <sys/sendfile.h>
+#include <cerrno>
+#endif
 
 namespace http_server {
 
+namespace {
+
+void LogError(beast::error_code ec, std::string_view where) {
+    json::object error;
+    error["code"s] = ec.value();
+    error["text"s] = ec.message();
+    error["where"s] = where;
+    BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, error)
+                            << "error"sv;
+}
+
+}  // namespace
+
+WebSocketSession::WebSocketSession(beast::tcp_stream&& stream)
+    : ws_(std::move(stream)) {
+    // Таймаут HTTP-сессии заменяется таймаутами и ping-ами самого websocket
+    beast::get_lowest_layer(ws_).expires_never();
+    ws_.set_option(websocket::stream_base::timeout::suggested(beast::role_type::server));
+    ws_.text(true);
+}
+
+void WebSocketSession::Run(http::request<http::string_body>&& request, OpenHandler on_open) {
+    net::dispatch(ws_.get_executor(),
+                  [self = shared_from_this(), request = std::move(request), on_open = std::move(on_open)] {
+                      self->ws_.async_accept(request, beast::bind_front_handler(&WebSocketSession::OnAccept, self, on_open));
+                  });
+}
+
+void WebSocketSession::OnAccept(const OpenHandler& on_open, beast::error_code ec) {
+    if (ec) {
+        return LogError(ec, "websocket accept"sv);
+    }
+
+    open_ = true;
+    Read();
+    on_open(shared_from_this());
+}
+
+void WebSocketSession::Read() {
+    ws_.async_read(read_buffer_, beast::bind_front_handler(&WebSocketSession::OnRead, shared_from_this()));
+}
+
+void WebSocketSession::OnRead(beast::error_code ec, std::size_t bytes_read) {
+    if (ec) {
+        open_ = false;
+        if (ec != websocket::error::closed) {
+            LogError(ec, "websocket read"sv);
+        }
+        return;
+    }
+
+    // Сообщения клиента не используются, чтение нужно для обработки ping и close
+    read_buffer_.consume(read_buffer_.size());
+    Read();
+}
+
+void WebSocketSession::Send(Frame frame) {
+    net::post(ws_.get_executor(), [self = shared_from_this(), frame = std::move(frame)]() mutable {
+        self->Enqueue(std::move(frame));
+    });
+}
+
+void WebSocketSession::Close() {
+    net::post(ws_.get_executor(), [self = shared_from_this()] {
+        if (!self->open_.exchange(false)) {
+            return;
+        }
+        self->pending_frames_.clear();
+        self->ws_.async_close(websocket::close_code::normal, [self](beast::error_code ec) {
+            if (ec) {
+                LogError(ec, "websocket close"sv);
+            }
+        });
+    });
+}
+
+void WebSocketSession::Enqueue(Frame frame) {
+    if (!open_) {
+        return;
+    }
+
+    if (pending_frames_.size() >= MAX_PENDING_FRAMES) {
+        // Клиент не успевает читать, устаревший кадр уступает место новому
+        pending_frames_.pop_front();
+    }
+    pending_frames_.push_back(std::move(frame));
+
+    if (!writing_frame_) {
+        Write();
+    }
+}
+
+void WebSocketSession::Write() {
+    writing_frame_ = std::move(pending_frames_.front());
+    pending_frames_.pop_front();
+
+    ws_.async_write(net::buffer(*writing_frame_),
+                    beast::bind_front_handler(&WebSocketSession::OnWrite, shared_from_this()));
+}
+
+void WebSocketSession::OnWrite(beast::error_code ec, std::size_t bytes_written) {
+    writing_frame_.reset();
+
+    if (ec) {
+        open_ = false;
+        pending_frames_.clear();
+        return LogError(ec, "websocket write"sv);
+    }
+
+    if (open_ && !pending_frames_.empty()) {
+        Write();
+    }
+}
+
 SessionBase::SessionBase(tcp::socket&& socket)
     : stream_(std::move(socket)) {
 }   
@@ -67,6 +187,101 @@ void SessionBase::OnWrite(bool close, beast::error_code ec, std::size_t bytes_wr
     Read();
 }
 
+struct SessionBase::SendfileOperation {
+    SendfileOperation(http::response<SendfileBody>&& message, const tcp::socket::executor_type& executor)
+        : response(std::move(message))
+        , serializer(response)
+        , offset(static_cast<off_t>(response.body().offset))
+        , remain(response.body().length)
+        , deadline(executor) {
+    }
+
+    http::response<SendfileBody> response;
+    http::response_serializer<SendfileBody> serializer;
+    off_t offset;
+    std::uint64_t remain;
+    // Ожидание готовности сокета идёт мимо таймаута tcp_stream, поэтому у него свой таймер
+    net::steady_timer deadline;
+};
+
+void SessionBase::Write(http::response<SendfileBody>&& response) {
+#ifdef __linux__
+    auto operation = std::make_shared<SendfileOperation>(std::move(response), stream_.get_executor());
+
+    http::async_write_header(stream_, operation->serializer,
+                             [operation, self = GetSharedThis()](beast::error_code ec, std::size_t bytes_written) {
+                                 if (ec) {
+                                     return self->OnWrite(true, ec, bytes_written);
+                                 }
+                                 self->SendFileBody(operation);
+                             });
+#else
+    Write<SendfileBody, http::fields>(std::move(response));
+#endif
+}
+
+void SessionBase::SendFileBody([[maybe_unused]] std::shared_ptr<SendfileOperation> operation) {
+#ifdef __linux__
+    // За один вызов sendfile передаёт не больше 0x7ffff000 байт
+    constexpr std::uint64_t MAX_CHUNK = 0x7ffff000;
+
+    auto& socket = stream_.socket();
+    const int file_fd = operation->response.body().file.native_handle();
+
+    // Заполненный буфер сокета не должен блокировать поток, вместо этого ждём готовности к записи
+    beast::error_code ec;
+    socket.native_non_blocking(true, ec);
+
+    while (!ec && operation->remain > 0) {
+        const auto chunk = static_cast<std::size_t>(std::min(operation->remain, MAX_CHUNK));
+        const ssize_t sent = ::sendfile(socket.native_handle(), file_fd, &operation->offset, chunk);
+
+        if (sent > 0) {
+            operation->remain -= static_cast<std::uint64_t>(sent);
+        }
+        else if (sent < 0 && errno == EINTR) {
+            continue;
+        }
+        else if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            // Клиент, переставший читать, не должен удерживать соединение и файл бесконечно
+            operation->deadline.expires_after(write_timeout_);
+            operation->deadline.async_wait([operation, self = GetSharedThis()](beast::error_code timer_ec) {
+                // Таймер мог сработать одновременно с готовностью сокета и уже быть перезапущен
+                if (!timer_ec && operation->deadline.expiry() <= net::steady_timer::clock_type::now()) {
+                    self->stream_.socket().cancel();
+                }
+            });
+
+            return socket.async_wait(tcp::socket::wait_write,
+                                     [operation, self = GetSharedThis()](beast::error_code wait_ec) {
+                                         operation->deadline.cancel();
+                                         if (wait_ec == net::error::operation_aborted) {
+                                             wait_ec = beast::error::timeout;
+                                         }
+                                         if (wait_ec) {
+                                             return self->OnWrite(true, wait_ec, 0);
+                                         }
+                                         self->SendFileBody(operation);
+                                     });
+        }
+        else if (sent == 0) {
+            // Файл стал короче заявленной в заголовке длины
+            ec = http::error::short_read;
+        }
+        else {
+            ec.assign(errno, boost::system::system_category());
+        }
+    }
+
+    // Часть тела могла уже уйти клиенту, поэтому после ошибки соединение закрывается
+    OnWrite(ec || operation->response.need_eof(), ec, 0);
+#endif
+}
+
+void SessionBase::UpgradeToWebSocket(HttpRequest&& request, WebSocketSession::OpenHandler on_open) {
+    std::make_shared<WebSocketSession>(std::move(stream_))->Run(std::move(request), std::move(on_open));
+}
+
 void SessionBase::Close() {
     stream_.socket().shutdown(tcp::socket::shutdown_send);
 }
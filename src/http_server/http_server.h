@@ -7,6 +7,14 @@
 #include <boost/asio/strand.hpp>
 #include <boost/beast/core.hpp>
 #include <boost/beast/http.hpp>
+#include <boost/beast/websocket.hpp>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <functional>
+#include <memory>
 
 #include "../logger_helper.h"
 
@@ -16,9 +24,117 @@ namespace net = boost::asio;
 using tcp = net::ip::tcp;
 namespace beast = boost::beast;
 namespace http = beast::http;
+namespace websocket = beast::websocket;
 
 using namespace std::literals;
 
+/*
+ *  WebSocket-соединение, в которое сервер отправляет кадры по своей инициативе.
+ *  Send можно вызывать из любого потока, кадры записываются в strand соединения.
+ *  Пока идёт запись, ожидают не больше MAX_PENDING_FRAMES кадров: если клиент
+ *  не успевает их читать, самые старые из ожидающих кадров отбрасываются.
+ */
+class WebSocketSession : public std::enable_shared_from_this<WebSocketSession> {
+public:
+    using Frame = std::shared_ptr<const std::string>;
+    using OpenHandler = std::function<void(std::shared_ptr<WebSocketSession>)>;
+
+    // Кадр содержит полное состояние, поэтому промежуточные кадры можно не доставлять
+    static constexpr size_t MAX_PENDING_FRAMES = 1;
+
+    explicit WebSocketSession(beast::tcp_stream&& stream);
+
+    WebSocketSession(const WebSocketSession&) = delete;
+    WebSocketSession& operator=(const WebSocketSession&) = delete;
+
+    // Выполняет рукопожатие по запросу request и после успеха вызывает on_open
+    void Run(http::request<http::string_body>&& request, OpenHandler on_open);
+
+    void Send(Frame frame);
+    void Close();
+
+    bool IsOpen() const {
+        return open_;
+    }
+
+private:
+    void OnAccept(const OpenHandler& on_open, beast::error_code ec);
+    void Read();
+    void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
+    void Enqueue(Frame frame);
+    void Write();
+    void OnWrite(beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
+
+private:
+    websocket::stream<beast::tcp_stream> ws_;
+    beast::flat_buffer read_buffer_;
+    // Отправляемый кадр, nullptr если запись не идёт
+    Frame writing_frame_;
+    std::deque<Frame> pending_frames_;
+    std::atomic<bool> open_ = false;
+};
+
+using WebSocketSessionPtr = std::shared_ptr<WebSocketSession>;
+
+/*
+ *  Тело ответа - участок открытого файла [offset, offset + length).
+ *  На Linux SessionBase отправляет его через sendfile, минуя буферы процесса,
+ *  на других платформах файл читается блоками, как в http::file_body.
+ */
+struct SendfileBody {
+    // Размер блока при чтении файла без sendfile
+    static constexpr std::size_t BUFFER_SIZE = 4096;
+
+    struct value_type {
+        beast::file file;
+        std::uint64_t offset = 0;
+        std::uint64_t length = 0;
+    };
+
+    static std::uint64_t size(const value_type& body) {
+        return body.length;
+    }
+
+    class writer {
+    public:
+        using const_buffers_type = net::const_buffer;
+
+        template <bool isRequest, class Fields>
+        writer([[maybe_unused]] http::header<isRequest, Fields>& header, value_type& body)
+            : body_(body)
+            , remain_(body.length) {
+        }
+
+        void init(beast::error_code& ec) {
+            body_.file.seek(body_.offset, ec);
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec) {
+            ec = {};
+            if (remain_ == 0) {
+                return boost::none;
+            }
+
+            const auto amount = static_cast<std::size_t>(std::min<std::uint64_t>(remain_, sizeof(buffer_)));
+            const auto bytes_read = body_.file.read(buffer_, amount, ec);
+            if (ec) {
+                return boost::none;
+            }
+            if (bytes_read == 0) {
+                ec = http::error::short_read;
+                return boost::none;
+            }
+
+            remain_ -= bytes_read;
+            return {{net::const_buffer(buffer_, bytes_read), remain_ > 0}};
+        }
+
+    private:
+        value_type& body_;
+        std::uint64_t remain_;
+        char buffer_[BUFFER_SIZE];
+    };
+};
 
 class SessionBase {
 public:
@@ -28,12 +144,21 @@ public:
 
     void Run();
 
+    // Сколько ждать, пока клиент освободит буфер сокета при отправке файла, прежде чем закрыть соединение
+    void SetWriteTimeout(std::chrono::steady_clock::duration timeout) { write_timeout_ = timeout; }
+
 protected:
     explicit SessionBase(tcp::socket&& socket);    
     ~SessionBase() = default;
 
     using HttpRequest = http::request<http::string_body>;
 
+    // Заголовок отправляется сериализатором, а тело - через sendfile, см. SendfileBody
+    void Write(http::response<SendfileBody>&& response);
+
+    // Передаёт соединение WebSocketSession, после этого сессия больше не читает запросы
+    void UpgradeToWebSocket(HttpRequest&& request, WebSocketSession::OpenHandler on_open);
+
     template <typename Body, typename Fields>
     void Write(http::response<Body, Fields>&& response) {
         // Запись выполняется асинхронно, поэтому response перемещаем в область кучи
@@ -47,8 +172,11 @@ protected:
     }    
 
 private:
+    struct SendfileOperation;
+
     void Read();
     void OnRead(beast::error_code ec, [[maybe_unused]] std::size_t bytes_read);
+    void SendFileBody(std::shared_ptr<SendfileOperation> operation);
     void OnWrite(bool close, beast::error_code ec, [[maybe_unused]] std::size_t bytes_written);
     void Close();
 
@@ -62,6 +190,7 @@ private:
     beast::tcp_stream stream_;
     beast::flat_buffer buffer_;
     HttpRequest request_;
+    std::chrono::steady_clock::duration write_timeout_ = 30s;
 };
 
 template <typename RequestHandler>
@@ -81,6 +210,15 @@ private:
         // чтобы продлить время жизни сессии до вызова лямбды.
         // Используется generic-лямбда функция, способная принять response произвольного типа
 
+        if (websocket::is_upgrade(request)) {
+            // Обработчик либо отвечает ошибкой, либо принимает соединение
+            return request_handler_.Upgrade(std::move(request), [self = this->shared_from_this()](auto&& response) {
+                self->Write(std::move(response));
+            }, [self = this->shared_from_this()](HttpRequest&& upgrade_request, WebSocketSession::OpenHandler on_open) {
+                self->UpgradeToWebSocket(std::move(upgrade_request), std::move(on_open));
+            }, remote_ip_);
+        }
+
         request_handler_(std::move(request), [self = this->shared_from_this()](auto&& response) {
             self->Write(std::move(response));
         }, remote_ip_);
@@ -14,24 +14,40 @@ public:
     PlayerRepr() = default;
     explicit PlayerRepr(const application::Player& player)
     : player_id_{ *player.GetDog()->GetDogId() }
-    , game_session_id_{ *player.GetSession().GetMapId() } {  
+    , game_session_id_{ *player.GetSession().GetMapId() }
+    , session_id_{ *player.GetSession().GetId() } {  
     }
 
     application::Player Restore(application::Application& app) {
-        model::GameSession* session = app.GetGame().GetSession(game_session_id_);
+        auto& game = app.GetGame();
+        model::GameSession* session = nullptr;
+
+        if (session_id_) {
+            session = game.FindSession(model::GameSession::Id{ *session_id_ });
+        } else if (auto map_sessions = game.GetMapSessions(game_session_id_); !map_sessions.empty()) {
+            // До версии 1 у карты была ровно одна сессия
+            session = game.FindSession(map_sessions.front());
+        }
+
         auto dog = session->GetDog(player_id_);
         return application::Player{ session, dog };
     }
 
     template <typename Archive>
-    void serialize(Archive& ar, [[maybe_unused]] const unsigned version) {
+    void serialize(Archive& ar, const unsigned version) {
         ar& player_id_;
         ar& *game_session_id_;
+        if (version >= 1) {
+            std::uint64_t session_id = session_id_.value_or(0);
+            ar& session_id;
+            session_id_ = session_id;
+        }
     }
 
 private:
     std::uint64_t player_id_;
     model::Map::Id game_session_id_{""};
+    std::optional<std::uint64_t> session_id_;
 };
 
 class PlayerTokensRepr {
@@ -40,14 +56,16 @@ public:
 
     explicit PlayerTokensRepr(const application::Players::PlayerIdToIndex& token_to_index) {
         for (const auto& [token, index] : token_to_index) {
-            player_tokens_.emplace(*token, index);
+            player_tokens_.emplace(token.ToHex(), index);
         }
     }
 
     application::Players::PlayerIdToIndex Restore() {
         application::Players::PlayerIdToIndex token_to_index;
         for (const auto& [token, index] : player_tokens_) {
-            token_to_index.emplace(application::Token(token), index);
+            if (auto parsed = application::Token::FromHex(token)) {
+                token_to_index.emplace(*parsed, index);
+            }
         }
 
         return std::move(token_to_index);
@@ -68,8 +86,8 @@ public:
     explicit PlayersRepr(const application::Players& players)
         : player_tokens_repr_(players.GetPlayerIdToIndex()) {
 
-        for (const auto& player : players.GetPlayers()) {
-            players_repr_.emplace_back(PlayerRepr{player});
+        for (const auto* player : players.GetPlayers()) {
+            players_repr_.emplace_back(PlayerRepr{*player});
         }
     }
 
@@ -80,8 +98,7 @@ public:
             players.emplace_back(player_repr.Restore(app));
         }
 
-        appPlayers.SetPlayers(std::move(players));
-        appPlayers.SetPlayerIdToIndex(player_tokens_repr_.Restore());
+        appPlayers.Restore(std::move(players), player_tokens_repr_.Restore());
     }
     
     template <typename Archive>
@@ -110,6 +127,7 @@ public:
         game_repr_.Restore(app.GetGame());
         players_repr_.Restore(app, app.GetPlayers());
         app.SetRandomSpawn(random_spawn_);
+        app.PublishSnapshots();
     }
 
     template <typename Archive>
@@ -125,4 +143,7 @@ private:
     bool random_spawn_ = false;
 };
 
-}
\ No newline at end of file
+}
+
+// Версия 1: id сессии игрока
+BOOST_CLASS_VERSION(::serialization::PlayerRepr, 1)
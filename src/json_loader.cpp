@@ -147,6 +147,22 @@ model::Game LoadGame(const std::filesystem::path& json_path) {
         game.SetDogRetirementTime(static_cast<float>(json.at(Properties::DOG_RETIREMENT_TIME).as_double() * ONE_SECOND));
     }
 
+    if (json.as_object().contains(Properties::RANDOM_SEED)) {
+
+        // Зерно может быть больше INT64_MAX, такие числа разбираются как uint64
+        game.SetRandomSeed(json::value_to<std::uint64_t>(json.at(Properties::RANDOM_SEED)));
+    }
+
+    if (json.as_object().contains(Properties::MAX_PLAYERS_PER_SESSION)) {
+
+        // При 0 каждый игрок получал бы новую сессию, а отрицательное значение отключило бы ограничение
+        auto max_players = json.at(Properties::MAX_PLAYERS_PER_SESSION).as_int64();
+        if (max_players < 1)
+            throw std::invalid_argument("maxPlayersPerSession must be positive");
+
+        game.SetMaxPlayersPerSession(static_cast<size_t>(max_players));
+    }
+
     for (const auto& map_item : json.at(Properties::MAPS_ARRAY).as_array())
     {
         std::string id = map_item.at(Properties::MAP_ID).as_string().c_str();
@@ -60,6 +60,11 @@ int main(int argc, const char* argv[]) {
         }
 
         model::Game game = json_loader::LoadGame(args->config_file_path);
+
+        if (args->random_seed) {
+            game.SetRandomSeed(*args->random_seed);
+        }
+
         postgres::Database db {db_url};
         application::Application app(game, db, args->randomize_spawn_dog);
         std::shared_ptr<infrastructure::SerializingListener> listener;
@@ -71,12 +76,14 @@ int main(int argc, const char* argv[]) {
             if (args->save_state_period > 0)
                 listener->SetSavePeriod(std::chrono::milliseconds(args->save_state_period));
 
-            app.SetUpdateListener(listener);    
+            app.AddUpdateListener(listener);    
         }
 
         const unsigned num_threads = std::thread::hardware_concurrency();
         net::io_context ioc(num_threads);
 
+        app.SetTickThreads(args->tick_threads > 0 ? args->tick_threads : num_threads);
+
         net::signal_set signals(ioc, SIGINT, SIGTERM);
 
         signals.async_wait([&ioc](const sys::error_code& ec, [[maybe_unused]] int signal_number) {
@@ -88,14 +95,25 @@ int main(int argc, const char* argv[]) {
         auto api_strand = net::make_strand(ioc);
         auto api_handler = std::make_shared<http_handler::APIRequestHandler>(app, api_strand);
 
+        // Состояние рассылается подписчикам после сохранения игры
+        auto state_broadcaster = std::make_shared<http_handler::StateBroadcaster>(app);
+        app.AddUpdateListener(state_broadcaster);
+        api_handler->SetStateBroadcaster(state_broadcaster);
+
         if (args->tick_period > 0) {
             auto ticker = std::make_shared<Ticker>(api_strand, std::chrono::milliseconds(args->tick_period),
                 [&app](std::chrono::milliseconds delta) { app.UpdateGameState(delta); }
             );
+
+            if (args->fixed_tick) {
+                ticker->SetFixedStep(args->max_catch_up_ticks);
+            }
+
             ticker->Start();        
         }
 
         http_handler::RequestHandler handler(api_handler, args->www_root);
+        handler.SetStaticCacheCapacity(args->static_cache_size * 1024 * 1024);
 
         http_handler::LoggingRequestHandler logging_handler (handler);
 
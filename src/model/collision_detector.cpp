@@ -1,5 +1,14 @@
 #include "collision_detector.h"
 #include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <optional>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define COLLISION_DETECTOR_AVX2
+#include <immintrin.h>
+#endif
 
 namespace collision_detector {
 
@@ -22,32 +31,239 @@ CollectionResult TryCollectPoint(geom::Point2D a, geom::Point2D b, geom::Point2D
     return CollectionResult(sq_distance, proj_ratio);
 }
 
+void TryCollectPointsScalar(const Gatherer& gatherer, const ItemsBatch& items, BatchCollectionResult& result) {
+    const size_t count = items.Size();
+    result.collected.resize(count);
+    result.sq_distance.resize(count);
+    result.proj_ratio.resize(count);
+
+    for (size_t i = 0; i < count; ++i) {
+        auto collect_result = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, {items.x[i], items.y[i]});
+        result.collected[i] = collect_result.IsCollected(gatherer.width + items.width[i]);
+        result.sq_distance[i] = collect_result.sq_distance;
+        result.proj_ratio[i] = collect_result.proj_ratio;
+    }
+}
+
+#ifdef COLLISION_DETECTOR_AVX2
+
+namespace {
+
+// Повторяет вычисления TryCollectPoint в том же порядке операций (без FMA),
+// поэтому результаты побитово совпадают со скалярной версией
+__attribute__((target("avx2")))
+void TryCollectPointsAvx2(const Gatherer& gatherer, const ItemsBatch& items, BatchCollectionResult& result) {
+    const size_t count = items.Size();
+    result.collected.resize(count);
+    result.sq_distance.resize(count);
+    result.proj_ratio.resize(count);
+
+    const geom::Point2D a = gatherer.start_pos;
+    const geom::Point2D b = gatherer.end_pos;
+    assert(b.x != a.x || b.y != a.y);
+
+    const double v_x = b.x - a.x;
+    const double v_y = b.y - a.y;
+    const double v_len2 = v_x * v_x + v_y * v_y;
+
+    const __m256d a_x4 = _mm256_set1_pd(a.x);
+    const __m256d a_y4 = _mm256_set1_pd(a.y);
+    const __m256d v_x4 = _mm256_set1_pd(v_x);
+    const __m256d v_y4 = _mm256_set1_pd(v_y);
+    const __m256d v_len2_4 = _mm256_set1_pd(v_len2);
+    const __m256d width4 = _mm256_set1_pd(gatherer.width);
+    const __m256d zero4 = _mm256_setzero_pd();
+    const __m256d one4 = _mm256_set1_pd(1.0);
 
-std::vector<GatheringEvent> FindGatherEvents(
-    const ItemGathererProvider& provider) {
+    constexpr size_t LANES = 4;
+    size_t i = 0;
+    for (; i + LANES <= count; i += LANES) {
+        const __m256d u_x = _mm256_sub_pd(_mm256_loadu_pd(&items.x[i]), a_x4);
+        const __m256d u_y = _mm256_sub_pd(_mm256_loadu_pd(&items.y[i]), a_y4);
+        const __m256d u_dot_v = _mm256_add_pd(_mm256_mul_pd(u_x, v_x4), _mm256_mul_pd(u_y, v_y4));
+        const __m256d u_len2 = _mm256_add_pd(_mm256_mul_pd(u_x, u_x), _mm256_mul_pd(u_y, u_y));
+        const __m256d proj_ratio = _mm256_div_pd(u_dot_v, v_len2_4);
+        const __m256d sq_distance
+            = _mm256_sub_pd(u_len2, _mm256_div_pd(_mm256_mul_pd(u_dot_v, u_dot_v), v_len2_4));
+
+        const __m256d radius = _mm256_add_pd(width4, _mm256_loadu_pd(&items.width[i]));
+        const __m256d hit = _mm256_and_pd(
+            _mm256_and_pd(_mm256_cmp_pd(proj_ratio, zero4, _CMP_GE_OQ),
+                          _mm256_cmp_pd(proj_ratio, one4, _CMP_LE_OQ)),
+            _mm256_cmp_pd(sq_distance, _mm256_mul_pd(radius, radius), _CMP_LE_OQ));
+
+        _mm256_storeu_pd(&result.sq_distance[i], sq_distance);
+        _mm256_storeu_pd(&result.proj_ratio[i], proj_ratio);
+
+        const int mask = _mm256_movemask_pd(hit);
+        for (size_t lane = 0; lane < LANES; ++lane) {
+            result.collected[i + lane] = (mask >> lane) & 1;
+        }
+    }
+
+    for (; i < count; ++i) {
+        auto collect_result = TryCollectPoint(a, b, {items.x[i], items.y[i]});
+        result.collected[i] = collect_result.IsCollected(gatherer.width + items.width[i]);
+        result.sq_distance[i] = collect_result.sq_distance;
+        result.proj_ratio[i] = collect_result.proj_ratio;
+    }
+}
+
+}  // namespace
+
+#endif
+
+void TryCollectPoints(const Gatherer& gatherer, const ItemsBatch& items, BatchCollectionResult& result) {
+#ifdef COLLISION_DETECTOR_AVX2
+    static const bool has_avx2 = __builtin_cpu_supports("avx2");
+    if (has_avx2) {
+        return TryCollectPointsAvx2(gatherer, items, result);
+    }
+#endif
+    TryCollectPointsScalar(gatherer, items, result);
+}
+
+namespace {
+
+// При меньшем числе пар предметов и сборщиков сетка не окупается
+constexpr size_t MIN_PAIRS_FOR_GRID = 256;
+
+/*
+ *  Равномерная сетка над предметами (broad phase).
+ *  Предметы хранятся отсортированными по ключу ячейки, поэтому сетка
+ *  строится одним выделением памяти и одной сортировкой.
+ */
+class ItemGrid {
+public:
+    ItemGrid(const ItemsBatch& items, double cell_size)
+        : cell_size_(cell_size) {
+        cells_.reserve(items.Size());
+        for (size_t i = 0; i < items.Size(); ++i) {
+            cells_.push_back({CellKey(ToCell(items.x[i]), ToCell(items.y[i])), i});
+        }
+        std::sort(cells_.begin(), cells_.end());
+    }
+
+    /*
+     * Добавляет в out индексы предметов из ячеек, пересекающих прямоугольник.
+     * Возвращает false, если ячеек больше max_cells - тогда выгоднее проверить все предметы
+     */
+    bool Query(double min_x, double min_y, double max_x, double max_y,
+               size_t max_cells, std::vector<size_t>& out) const {
+        const int64_t cx0 = ToCell(min_x);
+        const int64_t cy0 = ToCell(min_y);
+        const int64_t cx1 = ToCell(max_x);
+        const int64_t cy1 = ToCell(max_y);
+
+        if (static_cast<double>(cx1 - cx0 + 1) * static_cast<double>(cy1 - cy0 + 1)
+            > static_cast<double>(max_cells)) {
+            return false;
+        }
+
+        for (int64_t cx = cx0; cx <= cx1; ++cx) {
+            for (int64_t cy = cy0; cy <= cy1; ++cy) {
+                const uint64_t key = CellKey(cx, cy);
+                auto it = std::lower_bound(cells_.begin(), cells_.end(), Cell{key, 0});
+                for (; it != cells_.end() && it->key == key; ++it) {
+                    out.push_back(it->item);
+                }
+            }
+        }
+        return true;
+    }
+
+private:
+    struct Cell {
+        uint64_t key;
+        size_t item;
+
+        auto operator<=>(const Cell&) const = default;
+    };
+
+    int64_t ToCell(double coord) const {
+        constexpr double LIMIT = std::numeric_limits<int32_t>::max();
+        return static_cast<int64_t>(std::clamp(std::floor(coord / cell_size_), -LIMIT, LIMIT));
+    }
+
+    static uint64_t CellKey(int64_t cx, int64_t cy) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(cx)) << 32) | static_cast<uint32_t>(cy);
+    }
+
+    double cell_size_;
+    std::vector<Cell> cells_;
+};
+
+}  // namespace
+
+std::vector<GatheringEvent> FindGatherEvents(const ItemsBatch& items, std::span<const Gatherer> gatherers) {
     std::vector<GatheringEvent> detected_events;
 
     static auto eq_pt = [](geom::Point2D p1, geom::Point2D p2) {
         return p1.x == p2.x && p1.y == p2.y;
     };
 
-    for (size_t g = 0; g < provider.GatherersCount(); ++g) {
-        Gatherer gatherer = provider.GetGatherer(g);
+    const size_t items_count = items.Size();
+    const double max_item_width = items_count == 0 ? 0.
+        : *std::max_element(items.width.begin(), items.width.end());
+
+    std::optional<ItemGrid> grid;
+    if (items_count * gatherers.size() >= MIN_PAIRS_FOR_GRID) {
+        double max_gatherer_width = 0.;
+        for (const auto& gatherer : gatherers) {
+            max_gatherer_width = std::max(max_gatherer_width, gatherer.width);
+        }
+        // Ячейка не меньше радиуса сбора, чтобы короткий отрезок задевал несколько ячеек
+        grid.emplace(items, std::max(max_gatherer_width + max_item_width, 1.0));
+    }
+
+    std::vector<size_t> candidates;
+    ItemsBatch candidate_items;
+    BatchCollectionResult collect_results;
+
+    for (size_t g = 0; g < gatherers.size(); ++g) {
+        const Gatherer& gatherer = gatherers[g];
         if (eq_pt(gatherer.start_pos, gatherer.end_pos)) {
             continue;
         }
-        for (size_t i = 0; i < provider.ItemsCount(); ++i) {
-            Item item = provider.GetItem(i);
-            auto collect_result
-                = TryCollectPoint(gatherer.start_pos, gatherer.end_pos, item.position);
-
-            if (collect_result.IsCollected(gatherer.width + item.width)) {
-                GatheringEvent evt{.item_id = i,
-                                   .gatherer_id = g,
-                                   .sq_distance = collect_result.sq_distance,
-                                   .time = collect_result.proj_ratio};
-                detected_events.push_back(evt);
+
+        candidates.clear();
+
+        // Собранный предмет лежит не дальше радиуса сбора от отрезка,
+        // то есть внутри его ограничивающего прямоугольника, расширенного на радиус.
+        // Небольшой запас защищает от ошибок округления, точная проверка - TryCollectPoints
+        const double reach = gatherer.width + max_item_width + 1e-6;
+        const bool use_grid = grid && grid->Query(
+            std::min(gatherer.start_pos.x, gatherer.end_pos.x) - reach,
+            std::min(gatherer.start_pos.y, gatherer.end_pos.y) - reach,
+            std::max(gatherer.start_pos.x, gatherer.end_pos.x) + reach,
+            std::max(gatherer.start_pos.y, gatherer.end_pos.y) + reach,
+            items_count, candidates);
+
+        const ItemsBatch* batch = &items;
+        if (use_grid) {
+            // Проверяем кандидатов в порядке индексов, чтобы события до сортировки
+            // шли в том же порядке, что и при полном переборе
+            std::sort(candidates.begin(), candidates.end());
+            candidate_items.Clear();
+            for (size_t i : candidates) {
+                candidate_items.x.push_back(items.x[i]);
+                candidate_items.y.push_back(items.y[i]);
+                candidate_items.width.push_back(items.width[i]);
             }
+            batch = &candidate_items;
+        }
+
+        TryCollectPoints(gatherer, *batch, collect_results);
+
+        for (size_t k = 0; k < batch->Size(); ++k) {
+            if (!collect_results.collected[k]) {
+                continue;
+            }
+            GatheringEvent evt{.item_id = use_grid ? candidates[k] : k,
+                               .gatherer_id = g,
+                               .sq_distance = collect_results.sq_distance[k],
+                               .time = collect_results.proj_ratio[k]};
+            detected_events.push_back(evt);
         }
     }
 
@@ -59,4 +275,19 @@ std::vector<GatheringEvent> FindGatherEvents(
     return detected_events;
 }
 
-}  // namespace collision_detector
\ No newline at end of file
+std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider) {
+    ItemsBatch items;
+    for (size_t i = 0; i < provider.ItemsCount(); ++i) {
+        items.Add(provider.GetItem(i));
+    }
+
+    std::vector<Gatherer> gatherers;
+    gatherers.reserve(provider.GatherersCount());
+    for (size_t g = 0; g < provider.GatherersCount(); ++g) {
+        gatherers.push_back(provider.GetGatherer(g));
+    }
+
+    return FindGatherEvents(items, gatherers);
+}
+
+}  // namespace collision_detector
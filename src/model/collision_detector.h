@@ -3,6 +3,8 @@
 #include "geom.h"
 
 #include <algorithm>
+#include <cstdint>
+#include <span>
 #include <vector>
 
 namespace collision_detector {
@@ -32,6 +34,43 @@ struct Gatherer {
     double width;
 };
 
+// Предметы в виде структуры массивов для пакетной проверки сбора
+struct ItemsBatch {
+    std::vector<double> x;
+    std::vector<double> y;
+    std::vector<double> width;
+
+    size_t Size() const noexcept {
+        return x.size();
+    }
+
+    void Clear() noexcept {
+        x.clear();
+        y.clear();
+        width.clear();
+    }
+
+    void Add(const Item& item) {
+        x.push_back(item.position.x);
+        y.push_back(item.position.y);
+        width.push_back(item.width);
+    }
+};
+
+// Результат пакетной проверки: для каждого предмета пакета признак сбора,
+// квадрат расстояния и доля пройденного отрезка
+struct BatchCollectionResult {
+    std::vector<uint8_t> collected;
+    std::vector<double> sq_distance;
+    std::vector<double> proj_ratio;
+};
+
+// Движемся по отрезку сборщика и пытаемся подобрать каждый предмет пакета.
+// Использует AVX2, если его поддерживает процессор, иначе скалярную реализацию.
+// Результаты совпадают с TryCollectPoint и CollectionResult::IsCollected
+void TryCollectPoints(const Gatherer& gatherer, const ItemsBatch& items, BatchCollectionResult& result);
+void TryCollectPointsScalar(const Gatherer& gatherer, const ItemsBatch& items, BatchCollectionResult& result);
+
 class ItemGathererProvider {
 protected:
     ~ItemGathererProvider() = default;
@@ -50,6 +89,10 @@ struct GatheringEvent {
     double time;
 };
 
+// Ищет события сбора, читая предметы и сборщиков напрямую, без виртуальных вызовов
+std::vector<GatheringEvent> FindGatherEvents(const ItemsBatch& items, std::span<const Gatherer> gatherers);
+
+// Адаптер для ItemGathererProvider: один раз читает предметы и сборщиков из провайдера
 std::vector<GatheringEvent> FindGatherEvents(const ItemGathererProvider& provider);
 
 }  // namespace collision_detector
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include <stdexcept>
 #include <cassert>
+#include <tuple>
 
 
 namespace model {
@@ -67,48 +68,165 @@ Point Road::GetEnd() const noexcept {
     return end_;
 }
 
-Dog::Dog(std::string_view name) noexcept
-    : name_(name) {        
+RoadIndex::RoadIndex(std::vector<Road> roads)
+    : roads_(std::move(roads)) {
+
+    for (size_t index = 0; index < roads_.size(); ++index) {
+        const auto& road = roads_[index];
+        const auto start = road.GetStart();
+        const auto end = road.GetEnd();
+
+        // Границы считаются так же, как в Road::IsOnTheRoad
+        if (road.IsHorizontal()) {
+            horizontal_.Add(start.y, std::min(start.x, end.x) - road.width_,
+                            std::max(start.x, end.x) + road.width_, road.width_, index);
+        } else {
+            vertical_.Add(start.x, std::min(start.y, end.y) - road.width_,
+                          std::max(start.y, end.y) + road.width_, road.width_, index);
+        }
     }
 
+    horizontal_.Build();
+    vertical_.Build();
+}
+
+void RoadIndex::Axis::Build() {
+    std::sort(entries_.begin(), entries_.end(), [](const Entry& lhs, const Entry& rhs) {
+        return std::tie(lhs.key, lhs.lo) < std::tie(rhs.key, rhs.lo);
+    });
+
+    for (size_t i = 1; i < entries_.size(); ++i) {
+        if (entries_[i].key == entries_[i - 1].key) {
+            entries_[i].reach = std::max(entries_[i].hi, entries_[i - 1].reach);
+        }
+    }
+}
+
+void DogsState::PushBack(const Row& row) {
+    ids.push_back(row.id);
+    positions.push_back(row.position);
+    speeds.push_back(row.speed);
+    directions.push_back(row.direction);
+    rest_times.push_back(row.rest_time);
+    uptimes.push_back(row.uptime);
+    scores.push_back(row.score);
+    changed_ticks.push_back(row.changed_tick);
+}
+
+DogsState::Row DogsState::GetRow(size_t slot) const {
+    return { ids[slot], positions[slot], speeds[slot], directions[slot],
+             rest_times[slot], uptimes[slot], scores[slot], changed_ticks[slot] };
+}
+
+void DogsState::SetRow(size_t slot, const Row& row) {
+    ids[slot] = row.id;
+    positions[slot] = row.position;
+    speeds[slot] = row.speed;
+    directions[slot] = row.direction;
+    rest_times[slot] = row.rest_time;
+    uptimes[slot] = row.uptime;
+    scores[slot] = row.score;
+    changed_ticks[slot] = row.changed_tick;
+}
+
+void DogsState::Resize(size_t size) {
+    ids.resize(size);
+    positions.resize(size);
+    speeds.resize(size);
+    directions.resize(size);
+    rest_times.resize(size);
+    uptimes.resize(size);
+    scores.resize(size);
+    changed_ticks.resize(size);
+}
+
+Dog::Dog(std::string_view name)
+    : name_(name)
+    , storage_(std::make_shared<DogsState>()) {
+    storage_->PushBack({});
+}
+
+Dog::Dog(const Dog& other)
+    : name_(other.name_)
+    , default_speed_(other.default_speed_)
+    , bag_capacity_(other.bag_capacity_)
+    , bag_(other.bag_)
+    , storage_(std::make_shared<DogsState>()) {
+    storage_->PushBack(other.storage_->GetRow(other.slot_));
+}
+
+Dog& Dog::operator=(const Dog& other) {
+    if (this != &other) {
+        Dog copy{other};
+        name_ = std::move(copy.name_);
+        default_speed_ = copy.default_speed_;
+        bag_capacity_ = copy.bag_capacity_;
+        bag_ = std::move(copy.bag_);
+        storage_ = std::move(copy.storage_);
+        slot_ = copy.slot_;
+    }
+    return *this;
+}
+
+void Dog::Attach(std::shared_ptr<DogsState> storage) {
+    const size_t slot = storage->Size();
+    storage->PushBack(storage_->GetRow(slot_));
+    storage_ = std::move(storage);
+    slot_ = slot;
+    storage_->MarkChanged(slot_);
+}
+
+void Dog::Detach() {
+    auto own = std::make_shared<DogsState>();
+    own->PushBack(storage_->GetRow(slot_));
+    storage_ = std::move(own);
+    slot_ = 0;
+}
+
 void Dog::SetId(std::uint64_t dog_id) {
-    *id_ = dog_id;
+    storage_->ids[slot_] = dog_id;
 }
 
 void Dog::SetPosition(const Point& point) {
-    point_ = point;
+    storage_->positions[slot_] = point;
+    storage_->MarkChanged(slot_);
 }
 
 void Dog::Move(Direction dir) {
 
     if (dir != Direction::STOP) {
-        direction_ = dir;
+        storage_->directions[slot_] = dir;
         ResetRestTime();
     }
 
+    auto& speed = storage_->speeds[slot_];
+
     switch (dir) {
         case Direction::NORTH :
-            speed_ = {0.f, -default_speed_};
+            speed = {0.f, -default_speed_};
             break;
         case Direction::SOUTH :
-            speed_ = {0.f, default_speed_};
+            speed = {0.f, default_speed_};
             break;
         case Direction::EAST :
-            speed_ = {default_speed_, 0.f};
+            speed = {default_speed_, 0.f};
             break;
         case Direction::WEST :
-            speed_ = {-default_speed_, 0.f};
+            speed = {-default_speed_, 0.f};
             break;
         case Direction::STOP :
-            speed_ = {0.f, 0.f};
+            speed = {0.f, 0.f};
             break;
         default :
             assert(false);
     }    
+
+    storage_->MarkChanged(slot_);
 }
 
 void Dog::SetSpeed(const Speed& speed) {
-    speed_ = speed;
+    storage_->speeds[slot_] = speed;
+    storage_->MarkChanged(slot_);
 }
 
 void Dog::SetDefaultSpeed(float speed) {
@@ -122,32 +240,34 @@ void Dog::SetBagCapacity(unsigned int capacity)
 }
 
 Point Dog::GetPosition() const {
-    return point_;
+    return storage_->positions[slot_];
 }
 
 Speed Dog::GetSpeed() const {
-    return speed_;
+    return storage_->speeds[slot_];
 }
 
 void Dog::SetDirection(Direction dir) {
-    direction_ = dir;
+    storage_->directions[slot_] = dir;
+    storage_->MarkChanged(slot_);
 }
 
 bool Dog::PutToBag(const LootState& object) {
+    storage_->MarkChanged(slot_);
     return bag_.Add(object);
 }
 
 char Dog::GetDirection() const
 {
-    return static_cast<char>(direction_);
+    return static_cast<char>(storage_->directions[slot_]);
 }
 
 Direction Dog::GetDirectionEnm() const {
-    return direction_;
+    return storage_->directions[slot_];
 }
 
 Dog::Id Dog::GetDogId() const {
-    return id_;
+    return Id{storage_->ids[slot_]};
 }
 
 std::string Dog::GetName() const {
@@ -163,21 +283,72 @@ LostObjectsBag Dog::GetBag() const {
 }
 
 Point Dog::CalculateNextPosition(std::uint64_t time_delta) const {
+    return CalculateNextPosition(GetPosition(), GetSpeed(), time_delta);
+}
+
+Point Dog::CalculateNextPosition(Point point, Speed speed, std::uint64_t time_delta) {
     constexpr float ONE_SECOND = 1000.f;
-    auto x = point_.x + speed_.horizontal * (time_delta / ONE_SECOND);
-    auto y = point_.y + speed_.vertical * (time_delta / ONE_SECOND);
+    auto x = point.x + speed.horizontal * (time_delta / ONE_SECOND);
+    auto y = point.y + speed.vertical * (time_delta / ONE_SECOND);
 
     return { x, y };
 }
 
 void Dog::AccumulateScore(uint64_t score)
 {
-    score_ += score;
+    storage_->scores[slot_] += score;
+    storage_->MarkChanged(slot_);
 }
 
 uint64_t Dog::GetScore() const
 {
-    return score_;
+    return storage_->scores[slot_];
+}
+
+const LootState& LootStorage::Add(size_t type, Point position, uint64_t value, std::uint64_t tick) {
+    const int id = next_id_++;
+    id_to_index_.emplace(id, states_.size());
+    spawn_ticks_.push_back(tick);
+    return states_.emplace_back(id, type, position, value);
+}
+
+bool LootStorage::Remove(int id) {
+    auto it = id_to_index_.find(id);
+    if (it == id_to_index_.end()) {
+        return false;
+    }
+
+    const size_t index = it->second;
+    id_to_index_.erase(it);
+
+    if (index + 1 != states_.size()) {
+        states_[index] = std::move(states_.back());
+        spawn_ticks_[index] = spawn_ticks_.back();
+        id_to_index_[states_[index].id] = index;
+    }
+    states_.pop_back();
+    spawn_ticks_.pop_back();
+
+    return true;
+}
+
+const LootState* LootStorage::Find(int id) const {
+    if (auto it = id_to_index_.find(id); it != id_to_index_.end()) {
+        return &states_[it->second];
+    }
+    return nullptr;
+}
+
+void LootStorage::Reset(LootStates states, int min_next_id) {
+    states_ = std::move(states);
+    spawn_ticks_.assign(states_.size(), 0);
+    id_to_index_.clear();
+    next_id_ = std::max(next_id_, min_next_id);
+
+    for (size_t index = 0; index < states_.size(); ++index) {
+        id_to_index_[states_[index].id] = index;
+        next_id_ = std::max(next_id_, states_[index].id + 1);
+    }
 }
 
 RoadLoader::RoadLoader(const std::vector<Road>& roads) {
@@ -196,63 +367,73 @@ RoadLoader::RoadLoader(const std::vector<Road>& roads) {
 std::vector<Road> RoadLoader::GetDicts() const {
     std::vector<Road> src = vertical_roads_;
     src.insert(src.end(), horizontal_roads_.begin(), horizontal_roads_.end());
-    src.insert(src.end(), new_roads_.begin(), new_roads_.end());
 
     return src;
 }
 
-RoadLoader::RoadPairs RoadLoader::CheckRoads(const std::vector<Road>& roads) {
-    RoadPairs for_merging;
-
-    for (size_t i = 0; i < roads.size(); ++i) {
-        Road road1 = roads[i];
-        for (size_t j = i + 1; j < roads.size(); ++j) {
-            Road road2 = roads[j];
-
-            if (road1.IsVertical()) {
-                if (road1.GetStart().x == road2.GetStart().x) {
-                    if (road1.GetStart().y == road2.GetEnd().y || road1.GetEnd().y == road2.GetStart().y) {
-                        for_merging.push_back({ road1, road2 });
-                    }
-                }
-            } else {
-                if (road1.GetStart().y == road2.GetStart().y) {
-                    if (road1.GetStart().x == road2.GetEnd().x || road1.GetEnd().x == road2.GetStart().x) {
-                        for_merging.push_back({ road1, road2 });
-                    }
-                }
+namespace {
+
+// Координата оси дороги и её границы вдоль оси
+double RoadAxisKey(const Road& road) {
+    return road.IsHorizontal() ? road.GetStart().y : road.GetStart().x;
+}
+
+double RoadLow(const Road& road) {
+    return road.IsHorizontal() ? std::min(road.GetStart().x, road.GetEnd().x)
+                               : std::min(road.GetStart().y, road.GetEnd().y);
+}
+
+double RoadHigh(const Road& road) {
+    return road.IsHorizontal() ? std::max(road.GetStart().x, road.GetEnd().x)
+                               : std::max(road.GetStart().y, road.GetEnd().y);
+}
+
+}  // namespace
+
+std::vector<Road> RoadLoader::MergeCollinearRoads(std::vector<Road> roads) {
+    std::sort(roads.begin(), roads.end(), [](const Road& lhs, const Road& rhs) {
+        return std::tuple(RoadAxisKey(lhs), lhs.width_, RoadLow(lhs))
+             < std::tuple(RoadAxisKey(rhs), rhs.width_, RoadLow(rhs));
+    });
+
+    std::vector<Road> merged;
+    merged.reserve(roads.size());
+
+    for (const auto& road : roads) {
+        if (!merged.empty()) {
+            auto& last = merged.back();
+            if (RoadAxisKey(last) == RoadAxisKey(road) && last.width_ == road.width_
+                && RoadLow(road) <= RoadHigh(last)) {
+                last = MergeRoads(last, road);
+                continue;
             }
         }
+        merged.push_back(road);
     }
 
-    return for_merging;
+    return merged;
 }
 
 Road RoadLoader::MergeRoads(const Road& road1, const Road& road2) {
     Road result = road1;
 
-    result.start_.x = std::min(road1.GetStart().x, road2.GetStart().x);
-    result.end_.x = std::max(road1.GetEnd().x, road2.GetEnd().x);
-    result.start_.y = std::min(road1.GetStart().y, road2.GetStart().y);
-    result.end_.y = std::max(road1.GetEnd().y, road2.GetEnd().y);
+    const double low = std::min(RoadLow(road1), RoadLow(road2));
+    const double high = std::max(RoadHigh(road1), RoadHigh(road2));
+
+    if (road1.IsHorizontal()) {
+        result.start_.x = low;
+        result.end_.x = high;
+    } else {
+        result.start_.y = low;
+        result.end_.y = high;
+    }
 
     return result;
 }
 
 void RoadLoader::HandleTheRoads() {
-    RoadPairs verticalPairs = CheckRoads(vertical_roads_);
-    RoadPairs horizontalPairs = CheckRoads(horizontal_roads_);
-    
-    for ( auto& pair : verticalPairs) {
-        new_roads_.push_back(MergeRoads(pair[0], pair[1]));
-        vertical_roads_.erase(std::find(vertical_roads_.begin(), vertical_roads_.end(), pair[0]));
-        vertical_roads_.erase(std::find(vertical_roads_.begin(), vertical_roads_.end(), pair[1]));
-    }
-    for ( auto& pair : horizontalPairs) {
-        new_roads_.push_back(MergeRoads(pair[0], pair[1]));
-        horizontal_roads_.erase(std::find(horizontal_roads_.begin(), horizontal_roads_.end(), pair[0]));
-        horizontal_roads_.erase(std::find(horizontal_roads_.begin(), horizontal_roads_.end(), pair[1]));
-    }
+    vertical_roads_ = MergeCollinearRoads(std::move(vertical_roads_));
+    horizontal_roads_ = MergeCollinearRoads(std::move(horizontal_roads_));
 }
 
 void Map::AddOffice(Office office) {
@@ -271,11 +452,16 @@ void Map::AddOffice(Office office) {
     }
 }
 
-GameSession::GameSession(const Map& map, const LootGeneratorConfig& config, double dog_retirement_time) 
+GameSession::GameSession(const Map& map, const LootGeneratorConfig& config, double dog_retirement_time,
+                         std::optional<std::uint64_t> seed, Id id) 
     : map_(map) 
+    , id_(id)
     , loot_generator_(std::chrono::milliseconds{static_cast<uint64_t>(config.period_)}, config.probability_) 
     , dog_retirement_time_(dog_retirement_time)
-    , roads_ (RoadLoader(map.GetRoads()).GetDicts()) {
+    , road_index_(RoadLoader(map.GetRoads()).GetDicts())
+    // Зерно смешивается с id карты и сессии, чтобы сессии не повторяли друг друга
+    , random_(seed ? *seed ^ std::hash<std::string>{}(*map.GetId()) ^ (*id * 0x9e3779b97f4a7c15ULL)
+                   : util::Xoshiro256pp::RandomSeed()) {
     }
 
 std::uint64_t GameSession::AddDog(std::shared_ptr<model::Dog> dog, bool random_spawn) {
@@ -290,10 +476,54 @@ std::uint64_t GameSession::AddDog(std::shared_ptr<model::Dog> dog, bool random_s
         dog->SetPosition({road.GetStart().x, road.GetStart().y});
     }
 
-    dogs_.emplace_back(dog);
+    AttachDog(std::move(dog));
     return id;
 }
 
+void GameSession::EmplaceDogs(std::vector<std::shared_ptr<model::Dog>> dogs) {
+    for (auto& dog : dogs_) {
+        dog->Detach();
+    }
+    dogs_.clear();
+    dog_id_to_slot_.clear();
+    dogs_state_->Resize(0);
+
+    for (auto& dog : dogs) {
+        AttachDog(std::move(dog));
+    }
+}
+
+void GameSession::AttachDog(std::shared_ptr<model::Dog> dog) {
+    dog->Attach(dogs_state_);
+    dog_id_to_slot_[*dog->GetDogId()] = dogs_.size();
+    dogs_.emplace_back(std::move(dog));
+}
+
+void GameSession::RemoveRetiredDogs() {
+    auto& state = *dogs_state_;
+    size_t kept = 0;
+
+    // Удаляем строки с сохранением порядка: индексы собак совпадают с индексами сборщиков
+    for (size_t slot = 0; slot < dogs_.size(); ++slot) {
+        if (state.rest_times[slot] >= dog_retirement_time_) {
+            dog_id_to_slot_.erase(*dogs_[slot]->GetDogId());
+            dogs_[slot]->Detach();
+            continue;
+        }
+
+        if (kept != slot) {
+            state.SetRow(kept, state.GetRow(slot));
+            dogs_[kept] = std::move(dogs_[slot]);
+            dogs_[kept]->slot_ = kept;
+            dog_id_to_slot_[*dogs_[kept]->GetDogId()] = kept;
+        }
+        ++kept;
+    }
+
+    dogs_.resize(kept);
+    state.Resize(kept);
+}
+
 Map::Id GameSession::GetMapId() const {
     return map_.GetId();
 }
@@ -305,169 +535,188 @@ std::vector<std::shared_ptr<model::Dog>> GameSession::GetDogs() const
 
 std::optional<Point> GameSession::TryMoveOnMap(const Point& from, const Point& to) const {
 
-    std::vector<Road> start_roads;
+    std::optional<Point> most_far;
+    float max_distance = 0.f;
+    size_t most_far_index = 0;
 
-    std::copy_if(roads_.begin(), roads_.end(), std::back_inserter(start_roads), 
-        [&](const Road& road) {
-            return road.IsOnTheRoad(from);
-        });
-
-    if (start_roads.empty()) {
-        return std::nullopt;
-    }
-
-    auto most_far = start_roads[0].BoundToTheRoad(to);
-
-    if (start_roads.size() == 1) {
-        return most_far;
-    }
-
-    auto max_distance = Point::Distance(from, most_far);
-
-    for (std::size_t index = 1; index < start_roads.size(); ++index) {
-        auto pretender = start_roads[index].BoundToTheRoad(to);
+    road_index_.ForEachRoadAt(from, [&](size_t index, const Road& road) {
+        auto pretender = road.BoundToTheRoad(to);
         auto distance = Point::Distance(from, pretender);
 
-        if (distance > max_distance) {
+        // Индекс обходит дороги не по порядку, поэтому при равном расстоянии
+        // оставляем дорогу с меньшим индексом - как при линейном проходе
+        if (!most_far || distance > max_distance ||
+            (distance == max_distance && index < most_far_index)) {
             most_far = pretender;
             max_distance = distance;
+            most_far_index = index;
         }
-    }
+    });
 
     return most_far;
 }
 
-LootStates GameSession::GetLootStates() const
+std::span<const LootState> GameSession::GetLootStates() const
 {
-    return loot_states_;
+    return loot_.GetStates();
+}
+
+void GameSession::SetTick(std::uint64_t tick) {
+    dogs_state_->tick = tick;
+    history_start_tick_ = tick + 1;
+    removals_.clear();
+}
+
+void GameSession::SetLootStates(const LootStates& states) {
+    int min_next_id = 0;
+    for (const auto& dog : dogs_) {
+        for (const auto& obj : dog->GetBag().GetObjects()) {
+            min_next_id = std::max(min_next_id, obj.id + 1);
+        }
+    }
+    loot_.Reset(states, min_next_id);
 }
 
 void GameSession::GenerateLootOnMap(unsigned loot_to_gen)
 {
-    auto loot_types_size = map_.GetLootTypes().size();
     auto& loots = map_.GetLootTypes();
+    if (loots.empty()) {
+        return;
+    }
     
     for (size_t loot = 0; loot < loot_to_gen; ++loot) {
-        loot_states_.emplace_back(loot, GetRandomSizeT(loot_types_size), GenerateRandomPosition(), loots[loot].value_);
+        auto type = GetRandomSizeT(loots.size());
+        loot_.Add(type, GenerateRandomPosition(), loots[type].value_, dogs_state_->tick + 1);
     }
 }
 
 std::vector<Dog::Id> GameSession::UpdateGameState(const std::int64_t time_delta) {
 
+    auto& state = *dogs_state_;
+
     ItemDogProvider::Gatherers gatherers;
+    gatherers.reserve(state.Size());
 
     std::vector<Dog::Id> ids_to_remove;
 
-    for (auto& dog : dogs_) {      
+    for (size_t slot = 0; slot < state.Size(); ++slot) {
 
-        auto previuos_position = dog->GetPosition();
-        auto next_position = dog->CalculateNextPosition(time_delta);
+        auto previuos_position = state.positions[slot];
+        auto next_position = Dog::CalculateNextPosition(previuos_position, state.speeds[slot], time_delta);
 
         // bounding
-        auto new_position = TryMoveOnMap(dog->GetPosition(), next_position);
+        auto new_position = TryMoveOnMap(previuos_position, next_position);
 
-        if (new_position) {
-            dog->SetPosition(*new_position);
+        if (new_position && *new_position != previuos_position) {
+            state.positions[slot] = *new_position;
+            state.MarkChanged(slot);
         }
 
-        if (*new_position != next_position) {
-            dog->Move(Direction::STOP);
+        if ((!new_position || *new_position != next_position) && state.speeds[slot] != model::Speed{ 0.f, 0.f }) {
+            state.speeds[slot] = { 0.f, 0.f };
+            state.MarkChanged(slot);
         }
 
-        if (dog->GetSpeed() == model::Speed{ 0.f, 0.f }) {
-            dog->IncrementRestTime(time_delta);
+        if (state.speeds[slot] == model::Speed{ 0.f, 0.f }) {
+            state.rest_times[slot] += time_delta;
 
-            if (dog->GetRestTime() >= dog_retirement_time_) {
-                ids_to_remove.push_back(dog->GetDogId());
+            if (state.rest_times[slot] >= dog_retirement_time_) {
+                ids_to_remove.emplace_back(state.ids[slot]);
                 continue;
             }
         }
         else {
-            dog->ResetRestTime();
+            state.rest_times[slot] = 0.0;
         }
 
-        dog->IncrementUpTime(time_delta);
+        state.uptimes[slot] += time_delta;
 
         gatherers.emplace_back(
             previuos_position,
-            dog->GetPosition(),
+            state.positions[slot],
             GATHER_WIDTH);
     }
 
-    std::erase_if(dogs_, [this](const auto& dog) {
-        return dog->GetRestTime() >= dog_retirement_time_;
-    });
+    RemoveRetiredDogs();
 
-    auto loot_to_gen = loot_generator_.Generate(std::chrono::milliseconds{time_delta}, loot_states_.size(), dogs_.size());
+    auto loot_to_gen = loot_generator_.Generate(std::chrono::milliseconds{time_delta}, loot_.Size(), dogs_.size());
     GenerateLootOnMap(loot_to_gen);
 
     const auto& offices = map_.GetOffices();
-    ItemDogProvider::Items items;
+    collision_detector::ItemsBatch items;
 
-    items.reserve(loot_states_.size() + offices.size());
-
-    std::transform(loot_states_.begin(), loot_states_.end(), std::back_inserter(items),
-                   [](const LootState& state) {
-                       return collision_detector::Item{state.position, state.width};
-                   });
+    for (const auto& loot : loot_.GetStates()) {
+        items.Add({loot.position, loot.width});
+    }
 
-    size_t offices_start_idx = items.size();
+    size_t offices_start_idx = items.Size();
     for (const auto& office : offices) {
-        items.emplace_back(office.GetPosition(), OFFICE_WIDTH);
+        items.Add({office.GetPosition(), OFFICE_WIDTH});
     }
 
-    auto events = collision_detector::FindGatherEvents(
-        ItemDogProvider(std::move(items), std::move(gatherers))
-    );
+    auto events = collision_detector::FindGatherEvents(items, gatherers);
+
+    std::vector<bool> picked_up(offices_start_idx, false);
+    std::vector<int> picked_up_ids;
 
     for (const auto& event : events) {
 
-        auto& dog = dogs_[event.gatherer_id];
-        auto& bag = dog->GetBag();
+        auto& bag = dogs_[event.gatherer_id]->GetBag();
 
         if (event.item_id < offices_start_idx) {
 
-            auto& obj = loot_states_[event.item_id];
-            if (bag.IsFull() || obj.is_picked_up) {
+            if (bag.IsFull() || picked_up[event.item_id]) {
                 continue;
             }
 
+            auto obj = loot_.GetStates()[event.item_id];
             obj.is_picked_up = true;
+            picked_up[event.item_id] = true;
+            picked_up_ids.push_back(obj.id);
             bag.Add(obj);
+            state.MarkChanged(event.gatherer_id);
 
         } else {
             if (bag.IsEmpty()) {
                continue;
             }
 
-            dog->AccumulateScore(bag.Drop());
+            state.scores[event.gatherer_id] += bag.Drop();
+            state.MarkChanged(event.gatherer_id);
         }
     }
 
-    std::erase_if(loot_states_, [](const auto& obj) {
-        return obj.is_picked_up;
-    });
+    for (int id : picked_up_ids) {
+        loot_.Remove(id);
+    }
+
+    ++state.tick;
+
+    if (!ids_to_remove.empty() || !picked_up_ids.empty()) {
+        auto& removals = removals_.emplace_back();
+        removals.tick = state.tick;
+        for (const auto& id : ids_to_remove) {
+            removals.dog_ids.push_back(*id);
+        }
+        removals.loot_ids = std::move(picked_up_ids);
+    }
+
+    while (!removals_.empty() && removals_.front().tick <= GetHistoryStartTick()) {
+        removals_.pop_front();
+    }
 
     return ids_to_remove;
 }
 
 float GameSession::GenerateRandomFloat(float min, float max) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
     std::uniform_real_distribution<float> distribution(min, max);
     
-    return distribution(gen);
+    return distribution(random_);
 }
 
 Point GameSession::GenerateRandomPosition() {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_int_distribution<std::size_t> distribution(0, map_.GetRoads().size() - 1);
-
-    auto random_index = distribution(gen);
-
-    auto roads = map_.GetRoads();
-    auto road = roads[random_index];
+    const auto& roads = map_.GetRoads();
+    const auto& road = roads[GetRandomSizeT(roads.size())];
 
     Point start = road.GetStart();
     Point end = road.GetEnd();
@@ -490,10 +739,75 @@ Point GameSession::GenerateRandomPosition() {
 
 size_t GameSession::GetRandomSizeT(size_t n)
 {
-    std::random_device rd;
-    std::mt19937 gen(rd());
     std::uniform_int_distribution<size_t> distrib(0, n - 1);
-    return distrib(gen);
+    return distrib(random_);
+}
+
+GameSession* Game::GetSessionForJoin(const Map::Id& id) {
+    const Map* map = FindMap(id);
+    if (!map) {
+        return nullptr;
+    }
+
+    GameSession* least_loaded = nullptr;
+    for (const auto& session_id : map_sessions_[id]) {
+        auto& session = sessions_.at(session_id);
+        if (max_players_per_session_ && session.GetDogsCount() >= *max_players_per_session_) {
+            continue;
+        }
+        if (!least_loaded || session.GetDogsCount() < least_loaded->GetDogsCount()) {
+            least_loaded = &session;
+        }
+    }
+
+    if (least_loaded) {
+        return least_loaded;
+    }
+
+    const GameSession::Id session_id{next_session_id_++};
+    auto [it, inserted] = sessions_.emplace(session_id,
+        GameSession{*map, loot_generator_config_, dog_retirement_time_, random_seed_, session_id});
+    map_sessions_[id].push_back(session_id);
+
+    return &it->second;
+}
+
+std::vector<GameSession::Id> Game::RemoveEmptySessions() {
+    std::vector<GameSession::Id> removed;
+    if (!max_players_per_session_) {
+        return removed;
+    }
+
+    for (auto& [map_id, session_ids] : map_sessions_) {
+        std::erase_if(session_ids, [&](const GameSession::Id& session_id) {
+            auto it = sessions_.find(session_id);
+            if (it->second.GetDogsCount() != 0) {
+                return false;
+            }
+            removed.push_back(session_id);
+            sessions_.erase(it);
+            return true;
+        });
+    }
+
+    return removed;
+}
+
+void Game::SetGameSessions(GameSessions sessions) {
+    sessions_ = std::move(sessions);
+    map_sessions_.clear();
+    next_session_id_ = 0;
+
+    std::vector<GameSession::Id> ids;
+    for (const auto& [session_id, session] : sessions_) {
+        ids.push_back(session_id);
+        next_session_id_ = std::max(next_session_id_, *session_id + 1);
+    }
+    std::sort(ids.begin(), ids.end());
+
+    for (const auto& session_id : ids) {
+        map_sessions_[sessions_.at(session_id).GetMapId()].push_back(session_id);
+    }
 }
 
 void Game::AddMap(Map map) {
@@ -1,12 +1,16 @@
 #pragma once
 #include <string>
+#include <deque>
 #include <unordered_map>
 #include <vector>
 #include <memory>
 #include <optional>
 #include <random>
+#include <algorithm>
+#include <span>
 
 #include "tagged.h"
+#include "random_generator.h"
 #include "loot_generator.h"
 #include "collision_detector.h"
 #include "geom.h"
@@ -62,6 +66,99 @@ public:
     float width_;
 };
 
+/*
+ *  Индекс дорог карты для быстрого поиска дорог, на которых находится точка.
+ *  Горизонтальные дороги группируются по координате y, вертикальные - по x.
+ *  Внутри группы дороги отсортированы по левой (нижней) границе, что позволяет
+ *  находить дороги под точкой за O(log n + k) без выделения памяти.
+ */
+class RoadIndex {
+public:
+    RoadIndex() = default;
+    explicit RoadIndex(std::vector<Road> roads);
+
+    const std::vector<Road>& GetRoads() const noexcept {
+        return roads_;
+    }
+
+    /*
+     * Вызывает fn(index, road) для каждой дороги, для которой road.IsOnTheRoad(point) == true.
+     * index - позиция дороги в GetRoads(). Порядок обхода не гарантируется.
+     */
+    template <typename Fn>
+    void ForEachRoadAt(Point point, Fn&& fn) const {
+        horizontal_.ForEach(point.y, point.x, [&](size_t index) {
+            if (roads_[index].IsOnTheRoad(point)) {
+                fn(index, roads_[index]);
+            }
+        });
+        vertical_.ForEach(point.x, point.y, [&](size_t index) {
+            if (roads_[index].IsOnTheRoad(point)) {
+                fn(index, roads_[index]);
+            }
+        });
+    }
+
+private:
+    struct Entry {
+        // Координата оси дороги (y для горизонтальной, x для вертикальной)
+        double key;
+        // Границы дороги вдоль оси с учётом ширины
+        double lo;
+        double hi;
+        // Максимум hi среди дорог группы с индексом не больше текущего
+        double reach;
+        size_t road_index;
+    };
+
+    class Axis {
+    public:
+        void Add(double key, double lo, double hi, double width, size_t road_index) {
+            entries_.push_back({key, lo, hi, hi, road_index});
+            max_width_ = std::max(max_width_, width);
+        }
+
+        void Build();
+
+        template <typename Fn>
+        void ForEach(double key, double pos, Fn&& fn) const {
+            // Небольшой запас, чтобы не потерять дорогу из-за округления,
+            // точная проверка выполняется через Road::IsOnTheRoad
+            constexpr double SLACK = 1e-3;
+            const double reach = max_width_ + SLACK;
+
+            auto it = std::lower_bound(entries_.begin(), entries_.end(), key - reach,
+                [](const Entry& entry, double value) { return entry.key < value; });
+
+            while (it != entries_.end() && it->key <= key + reach) {
+                const double group_key = it->key;
+                auto group_end = std::upper_bound(it, entries_.end(), group_key,
+                    [](double value, const Entry& entry) { return value < entry.key; });
+
+                // Первая дорога группы, которая начинается правее pos
+                auto last = std::upper_bound(it, group_end, pos,
+                    [](double value, const Entry& entry) { return value < entry.lo; });
+
+                for (auto cur = last; cur != it && std::prev(cur)->reach >= pos; --cur) {
+                    if (std::prev(cur)->hi >= pos) {
+                        fn(std::prev(cur)->road_index);
+                    }
+                }
+
+                it = group_end;
+            }
+        }
+
+    private:
+        std::vector<Entry> entries_;
+        double max_width_ = 0.0;
+    };
+
+    std::vector<Road> roads_;
+    Axis horizontal_;
+    Axis vertical_;
+};
+
 class Building {
 public:
     explicit Building(const Rectangle& bounds) noexcept
@@ -232,6 +329,46 @@ struct LootState {
 
 using LootStates = std::vector<LootState>;
 
+/*
+ *  Трофеи на карте игровой сессии.
+ *  Трофеи хранятся в плотном массиве, индекс id -> позиция позволяет
+ *  удалять трофей за O(1), перемещая на его место последний.
+ *  Id выдаются монотонно и не повторяются в пределах сессии.
+ */
+class LootStorage {
+public:
+    const LootState& Add(size_t type, Point position, uint64_t value, std::uint64_t tick = 0);
+    bool Remove(int id);
+    const LootState* Find(int id) const;
+
+    std::span<const LootState> GetStates() const noexcept {
+        return states_;
+    }
+
+    // spawn_ticks[i] - тик появления трофея GetStates()[i]
+    std::span<const std::uint64_t> GetSpawnTicks() const noexcept {
+        return spawn_ticks_;
+    }
+
+    size_t Size() const noexcept {
+        return states_.size();
+    }
+
+    int GetNextId() const noexcept {
+        return next_id_;
+    }
+
+    // Заменяет все трофеи. Следующий id будет не меньше min_next_id
+    // и больше id любого из новых трофеев
+    void Reset(LootStates states, int min_next_id);
+
+private:
+    LootStates states_;
+    std::vector<std::uint64_t> spawn_ticks_;
+    std::unordered_map<int, size_t> id_to_index_;
+    int next_id_ = 0;
+};
+
 class LostObjectsBag {
   public:
 
@@ -280,11 +417,66 @@ class LostObjectsBag {
     size_t capacity_;
 };
 
+/*
+ *  Горячие данные собак игровой сессии, разложенные по массивам (structure of arrays).
+ *  Строка i всех массивов описывает одну собаку. Цикл обновления состояния сессии
+ *  проходит по массивам подряд, не обращаясь к объектам Dog.
+ */
+struct DogsState {
+    struct Row {
+        std::uint64_t id = 0;
+        Point position{ 0.f, 0.f };
+        Speed speed{ 0.f, 0.f };
+        Direction direction = Direction::NORTH;
+        double rest_time = 0.0;
+        double uptime = 0.0;
+        uint64_t score = 0;
+        std::uint64_t changed_tick = 0;
+    };
+
+    size_t Size() const noexcept {
+        return ids.size();
+    }
+
+    void PushBack(const Row& row);
+    Row GetRow(size_t slot) const;
+    void SetRow(size_t slot, const Row& row);
+    void Resize(size_t size);
+
+    std::vector<std::uint64_t> ids;
+    std::vector<Point> positions;
+    std::vector<Speed> speeds;
+    std::vector<Direction> directions;
+    std::vector<double> rest_times;
+    std::vector<double> uptimes;
+    std::vector<uint64_t> scores;
+    // Тик, на котором видимое клиентам состояние собаки изменилось последним
+    std::vector<std::uint64_t> changed_ticks;
+
+    // Последний завершённый тик сессии. Изменения между тиками относятся к следующему тику
+    std::uint64_t tick = 0;
+
+    void MarkChanged(size_t slot) {
+        changed_ticks[slot] = tick + 1;
+    }
+};
+
+/*
+ *  Собака - представление строки DogsState. Пока собака не добавлена в сессию,
+ *  она хранит свои данные в собственном DogsState из одной строки.
+ *  GameSession переносит строку в свои массивы при добавлении собаки
+ *  и возвращает её обратно при удалении. Холодные данные (имя, рюкзак)
+ *  хранятся в самом объекте Dog.
+ */
 class Dog {
 public:
     using Id = util::Tagged<std::uint64_t, Dog>;
 
-    explicit Dog(std::string_view name) noexcept;
+    explicit Dog(std::string_view name);
+
+    // Копия собаки всегда отвязана от сессии
+    Dog(const Dog& other);
+    Dog& operator=(const Dog& other);
 
     void SetId(std::uint64_t dog_id);
     void SetPosition(const Point& point);
@@ -308,60 +500,71 @@ public:
     LostObjectsBag& GetBag();
 
     Point CalculateNextPosition(std::uint64_t time_delta) const;
+    static Point CalculateNextPosition(Point point, Speed speed, std::uint64_t time_delta);
 
     void AccumulateScore(uint64_t score);
     uint64_t GetScore() const;
 
     void ResetRestTime() {
-        rest_time_ = 0.0;
+        storage_->rest_times[slot_] = 0.0;
     }
 
     void IncrementRestTime(double time_delta) {
-        rest_time_ += time_delta;
+        storage_->rest_times[slot_] += time_delta;
     }
 
     double GetRestTime() const {
-        return rest_time_;
+        return storage_->rest_times[slot_];
     }
 
     double GetUptime() const {
-        return uptime_;
+        return storage_->uptimes[slot_];
+    }
+
+    std::uint64_t GetChangedTick() const {
+        return storage_->changed_ticks[slot_];
     }
 
     void IncrementUpTime(double time_delta) {
-        uptime_ += time_delta;
+        storage_->uptimes[slot_] += time_delta;
     }
 
 private:
+    friend class GameSession;
+
+    // Переносит данные собаки в конец storage и делает её представлением этой строки
+    void Attach(std::shared_ptr<DogsState> storage);
+    // Копирует данные собаки в собственное хранилище
+    void Detach();
+
     std::string name_;
-    Id id_ {0};
-    Point point_{ 0.f, 0.f };
-    Speed speed_{ 0.f, 0.f };
-    Direction direction_{ Direction::NORTH };
     float default_speed_{1};
     unsigned int bag_capacity_ {3};
     LostObjectsBag bag_{bag_capacity_};
-    uint64_t score_ {0};
-    double rest_time_ = {0.0};
-    double uptime_ = {0.0};
+
+    std::shared_ptr<DogsState> storage_;
+    size_t slot_ = 0;
 };
 
+/*
+ *  Объединяет соосные дороги, которые касаются или перекрываются, в максимальные отрезки.
+ *  Дороги группируются по координате оси и ширине, сортируются и склеиваются
+ *  за один проход, поэтому цепочки из любого числа отрезков сливаются в одну дорогу.
+ */
 class RoadLoader {
 public:
-using RoadPairs = std::vector<std::vector<Road>>;
     explicit RoadLoader(const std::vector<Road>& roads);
 
     std::vector<Road> GetDicts() const;
 
 private:
 
-    static RoadPairs CheckRoads(const std::vector<Road>& roads);
+    static std::vector<Road> MergeCollinearRoads(std::vector<Road> roads);
     static Road MergeRoads(const Road& road1, const Road& road2);
     void HandleTheRoads(); 
 
     std::vector<Road> vertical_roads_;
     std::vector<Road> horizontal_roads_;
-    std::vector<Road> new_roads_;    
 };
 
 struct LootGeneratorConfig {
@@ -374,9 +577,11 @@ class ItemDogProvider : public collision_detector::ItemGathererProvider {
     using Items = std::vector<collision_detector::Item>;
     using Gatherers = std::vector<collision_detector::Gatherer>;
 
-    ItemDogProvider(Items items, Gatherers gatherers) :
-        items_(std::move(items)),
-        gatherers_(std::move(gatherers)) {}
+    // Не владеет данными: предметы и сборщики должны жить дольше провайдера
+    ItemDogProvider(std::span<const collision_detector::Item> items,
+                    std::span<const collision_detector::Gatherer> gatherers) :
+        items_(items),
+        gatherers_(gatherers) {}
 
     size_t ItemsCount() const override {
         return items_.size();
@@ -395,27 +600,51 @@ class ItemDogProvider : public collision_detector::ItemGathererProvider {
     }
 
   private:
-    Items items_;
-    Gatherers gatherers_;
+    std::span<const collision_detector::Item> items_;
+    std::span<const collision_detector::Gatherer> gatherers_;
+};
+
+// Сущности, удалённые из сессии на одном тике
+struct TickRemovals {
+    std::uint64_t tick = 0;
+    std::vector<std::uint64_t> dog_ids;
+    std::vector<int> loot_ids;
 };
 
 class GameSession {
 public:
-    explicit GameSession(const Map& map, const LootGeneratorConfig& config, double dog_retirement_time);
+    using Id = util::Tagged<std::uint64_t, GameSession>;
+
+    // seed - зерно генератора случайных чисел сессии, без него берётся случайное зерно.
+    // id различает сессии одной карты
+    explicit GameSession(const Map& map, const LootGeneratorConfig& config, double dog_retirement_time,
+                         std::optional<std::uint64_t> seed = std::nullopt, Id id = Id{0});
     GameSession() = delete;
 
+    // Собаки сессии ссылаются на её массивы, поэтому сессию можно только перемещать
+    GameSession(const GameSession&) = delete;
+    GameSession& operator=(const GameSession&) = delete;
+    GameSession(GameSession&&) = default;
+
     std::uint64_t AddDog(std::shared_ptr<model::Dog> dog, bool random_spawn);
     Map::Id GetMapId() const;
+
+    Id GetId() const noexcept {
+        return id_;
+    }
+
+    size_t GetDogsCount() const noexcept {
+        return dogs_.size();
+    }
+
     std::vector<std::shared_ptr<model::Dog>> GetDogs() const;
     std::vector<Dog::Id> UpdateGameState(const std::int64_t time_delta);
     std::optional<Point> TryMoveOnMap(const Point& from, const Point& to) const;
-    LootStates GetLootStates() const;
+    std::span<const LootState> GetLootStates() const;
 
     std::shared_ptr<model::Dog> GetDog(std::uint64_t id) {
-        for (auto& dog : dogs_) {
-            if (*dog->GetDogId() == id) {
-                return dog;
-            }
+        if (auto it = dog_id_to_slot_.find(id); it != dog_id_to_slot_.end()) {
+            return dogs_[it->second];
         }
         return nullptr;
     }
@@ -423,31 +652,65 @@ public:
     std::uint64_t GetDogIdCounter() const { return dog_id_counter_; }
     void SetDogIdCounter(std::uint64_t dog_id_counter) { dog_id_counter_ = dog_id_counter; }
 
-    void EmplaceDogs(std::vector<std::shared_ptr<model::Dog>> dogs) {
-        dogs_ = std::move(dogs);
-    }
+    void EmplaceDogs(std::vector<std::shared_ptr<model::Dog>> dogs);
 
     LootGeneratorConfig GetLootGeneratorConfig() const {
         return {loot_generator_.GetConfig().first, loot_generator_.GetConfig().second};
     }
 
-    void SetLootStates(const LootStates& states) {
-        loot_states_ = states;
+    // Восстанавливает трофеи. Новые id не пересекутся с id трофеев на карте и в рюкзаках собак
+    void SetLootStates(const LootStates& states);
+
+    // Сколько последних тиков хранится история удалений
+    static constexpr std::uint64_t CHANGES_HISTORY_TICKS = 128;
+
+    std::uint64_t GetTick() const noexcept {
+        return dogs_state_->tick;
+    }
+
+    // Устанавливает номер тика после восстановления. История удалений и тики появления
+    // трофеев не сохраняются, а клиент мог видеть и изменения, сделанные после сохранения,
+    // поэтому изменения нельзя получить относительно тика tick и более ранних
+    void SetTick(std::uint64_t tick);
+
+    // Самый ранний тик, относительно которого можно восстановить изменения
+    std::uint64_t GetHistoryStartTick() const noexcept {
+        const auto tick = GetTick();
+        return std::max(history_start_tick_, tick > CHANGES_HISTORY_TICKS ? tick - CHANGES_HISTORY_TICKS : 0);
+    }
+
+    const std::deque<TickRemovals>& GetRemovals() const noexcept {
+        return removals_;
+    }
+
+    std::span<const std::uint64_t> GetLootSpawnTicks() const noexcept {
+        return loot_.GetSpawnTicks();
     }
 
 private:
     void GenerateLootOnMap(unsigned loot_to_gen);
-    static float GenerateRandomFloat(float min, float max);
-    static size_t GetRandomSizeT(size_t n);
+    float GenerateRandomFloat(float min, float max);
+    size_t GetRandomSizeT(size_t n);
     Point GenerateRandomPosition();
 
+    void AttachDog(std::shared_ptr<model::Dog> dog);
+    void RemoveRetiredDogs();
+
     const Map map_;
+    Id id_;
+    // dogs_[i] - представление строки i массивов dogs_state_
     std::vector<std::shared_ptr<model::Dog>> dogs_;
+    // id собаки -> индекс в dogs_
+    std::unordered_map<std::uint64_t, size_t> dog_id_to_slot_;
+    std::shared_ptr<DogsState> dogs_state_ = std::make_shared<DogsState>();
     std::uint64_t dog_id_counter_{0};
-    std::vector<Road> roads_;
+    RoadIndex road_index_;
     loot_gen::LootGenerator loot_generator_;
-    LootStates loot_states_;
+    LootStorage loot_;
+    std::deque<TickRemovals> removals_;
+    std::uint64_t history_start_tick_ = 0;
     double dog_retirement_time_;
+    util::Xoshiro256pp random_;
 };
 
 class Game {
@@ -467,24 +730,38 @@ public:
         return nullptr;
     }
 
-    GameSession* GetSession(const model::Map::Id& id) {
-        if (sessions_.find(id) != sessions_.end()) {
-            return &sessions_.at(id);
-        }
+    // Сессия карты для нового игрока: наименее заполненная из сессий, где есть место.
+    // Если места нет, создаётся новая сессия. nullptr для неизвестной карты
+    GameSession* GetSessionForJoin(const Map::Id& id);
 
-        const Map* map = FindMap(id);
-        if (!map) {
-            return nullptr;
+    GameSession* FindSession(GameSession::Id id) {
+        if (auto it = sessions_.find(id); it != sessions_.end()) {
+            return &it->second;
         }
-        
-        auto p = sessions_.emplace(id, GameSession{*map, loot_generator_config_, dog_retirement_time_});
-        if (!p.second) {
-            return nullptr;
+        return nullptr;
+    }
+
+    // Сессии карты в порядке создания
+    std::vector<GameSession::Id> GetMapSessions(const Map::Id& id) const {
+        if (auto it = map_sessions_.find(id); it != map_sessions_.end()) {
+            return it->second;
         }
+        return {};
+    }
 
-        return &p.first->second;
+    // Наибольшее число игроков в одной сессии. Без ограничения у каждой карты одна сессия
+    void SetMaxPlayersPerSession(std::optional<size_t> max_players) {
+        max_players_per_session_ = max_players;
     }
 
+    std::optional<size_t> GetMaxPlayersPerSession() const {
+        return max_players_per_session_;
+    }
+
+    // Удаляет сессии, в которых не осталось собак. Работает только при ограничении
+    // числа игроков: без него сессия карты живёт вместе с трофеями на ней
+    std::vector<GameSession::Id> RemoveEmptySessions();
+
     void SetDefaultDogSpeed(float speed) {
         default_dog_speed_ = speed;
     }
@@ -516,25 +793,38 @@ public:
     double GetDogRetirementTime() const {
         return dog_retirement_time_;
     }
+
+    // Зерно для генераторов случайных чисел игровых сессий.
+    // Позволяет воспроизводить появление собак и трофеев
+    void SetRandomSeed(std::uint64_t seed) {
+        random_seed_ = seed;
+    }
+
+    std::optional<std::uint64_t> GetRandomSeed() const {
+        return random_seed_;
+    }
     
     using MapIdHasher = util::TaggedHasher<Map::Id>;
-    using GameSessions = std::unordered_map<Map::Id, GameSession, MapIdHasher>;
+    using SessionIdHasher = util::TaggedHasher<GameSession::Id>;
+    using GameSessions = std::unordered_map<GameSession::Id, GameSession, SessionIdHasher>;
 
     GameSessions& GetSessions() {
         return sessions_;
     }
 
-    GameSessions GetSessions() const {
+    const GameSessions& GetSessions() const {
         return sessions_;
     }
 
-    void SetGameSessions(GameSessions sessions) {
-        sessions_ = std::move(sessions);
-    }
+    void SetGameSessions(GameSessions sessions);
     
 private:
     using MapIdToIndex = std::unordered_map<Map::Id, size_t, MapIdHasher>;
     GameSessions sessions_;
+    // id карты -> её сессии в порядке создания
+    std::unordered_map<Map::Id, std::vector<GameSession::Id>, MapIdHasher> map_sessions_;
+    std::uint64_t next_session_id_ = 0;
+    std::optional<size_t> max_players_per_session_;
     std::vector<Map> maps_;
     MapIdToIndex map_id_to_index_;
 
@@ -543,6 +833,7 @@ private:
     std::optional<int> default_bag_capacity_;
     // defalut retirement time is 60 seconds
     double dog_retirement_time_{60 * 1000.0};
+    std::optional<std::uint64_t> random_seed_;
 };
 
 }  // namespace model
@@ -49,6 +49,13 @@ struct Properties{
     constexpr static char PLAYER_LOST_OBJECT_TYPE[] = "type";
     constexpr static char PLAYER_LOST_OBJECT_POS[] = "pos";
 
+    constexpr static char STATE_SINCE[] = "since";
+    constexpr static char STATE_RADIUS[] = "radius";
+    constexpr static char STATE_TICK[] = "tick";
+    constexpr static char STATE_FULL[] = "full";
+    constexpr static char STATE_REMOVED_PLAYERS[] = "removedPlayers";
+    constexpr static char STATE_REMOVED_LOST_OBJECTS[] = "removedLostObjects";
+
     constexpr static char MOVE_ACTION[] = "move";
 
     constexpr static char TIME_DELTA[] = "timeDelta";
@@ -71,4 +78,7 @@ struct Properties{
 
     constexpr static char DOG_RETIREMENT_TIME[] = "dogRetirementTime";
 
+    constexpr static char RANDOM_SEED[] = "randomSeed";
+    constexpr static char MAX_PLAYERS_PER_SESSION[] = "maxPlayersPerSession";
+
 };
\ No newline at end of file
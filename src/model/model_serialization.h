@@ -1,6 +1,7 @@
 #pragma once
 
 #include <boost/serialization/vector.hpp>
+#include <boost/serialization/version.hpp>
 
 #include "model.h"
 
@@ -105,8 +106,10 @@ public:
     explicit GameSessionRepr(const model::GameSession& session)
         : map_id_(session.GetMapId())
         , last_dog_id(session.GetDogIdCounter())
-        , loot_states_(session.GetLootStates())
-        , loot_gen_config_(session.GetLootGeneratorConfig()) {
+        , loot_states_(session.GetLootStates().begin(), session.GetLootStates().end())
+        , loot_gen_config_(session.GetLootGeneratorConfig())
+        , tick_(session.GetTick())
+        , id_(*session.GetId()) {
 
             for (const auto& dog : session.GetDogs()) {
                 dogs_repr_.emplace_back(DogRepr(*dog));
@@ -115,9 +118,10 @@ public:
 
     model::GameSession Restore(
             const model::Map* map, 
-            const model::LootGeneratorConfig loot_generator_config) {
+            const model::LootGeneratorConfig loot_generator_config,
+            std::optional<std::uint64_t> seed = std::nullopt) {
 
-        model::GameSession game_session(*map, loot_generator_config, 15.0);
+        model::GameSession game_session(*map, loot_generator_config, 15.0, seed, model::GameSession::Id{id_.value_or(0)});
         std::vector<std::shared_ptr<model::Dog>> dogs;
 
         for (const auto& dog_repr : dogs_repr_) {
@@ -127,30 +131,50 @@ public:
         game_session.EmplaceDogs(dogs);
         game_session.SetDogIdCounter(last_dog_id);
         game_session.SetLootStates(loot_states_);
+        game_session.SetTick(tick_);
 
 
         return game_session;
     }
 
     template <typename Archive>
-    void serialize(Archive& ar, [[maybe_unused]] const unsigned version) {
+    void serialize(Archive& ar, const unsigned version) {
         ar& *map_id_;
         ar& last_dog_id;
         ar& loot_states_;
         ar& dogs_repr_;
         ar& loot_gen_config_;
+        if (version >= 1) {
+            ar& tick_;
+        }
+        if (version >= 2) {
+            std::uint64_t id = id_.value_or(0);
+            ar& id;
+            id_ = id;
+        }
     }
 
     model::Map::Id GetMapId() {
         return map_id_;
     }
 
+    // У сессий из сохранений до версии 2 id нет, его назначает GameSessionsRepr
+    const std::optional<std::uint64_t>& GetId() const {
+        return id_;
+    }
+
+    void SetId(std::uint64_t id) {
+        id_ = id;
+    }
+
 private:
     model::Map::Id map_id_ {""};
     std::uint64_t last_dog_id {0};
     model::LootStates loot_states_;
     std::vector<DogRepr> dogs_repr_;
     model::LootGeneratorConfig loot_gen_config_;
+    std::uint64_t tick_ = 0;
+    std::optional<std::uint64_t> id_;
 };
 
 class GameSessionsRepr {
@@ -168,9 +192,21 @@ public:
 
         model::Game::GameSessions game_sessions;
 
+        std::uint64_t next_id = 0;
+        for (const auto& repr : game_sessions_repr_) {
+            if (repr.GetId()) {
+                next_id = std::max(next_id, *repr.GetId() + 1);
+            }
+        }
+
         for (auto& repr : game_sessions_repr_) {
+            if (!repr.GetId()) {
+                repr.SetId(next_id++);
+            }
+
             auto* map = game.FindMap(repr.GetMapId());
-            game_sessions.emplace(map->GetId(), repr.Restore(map, game.GetLootGeneratorConfig()));
+            auto session = repr.Restore(map, game.GetLootGeneratorConfig(), game.GetRandomSeed());
+            game_sessions.emplace(session.GetId(), std::move(session));
         }
 
         return game_sessions;
@@ -209,3 +245,7 @@ private:
 };
 
 }  // namespace serialization
+
+// Версия 1: номер тика сессии
+// Версия 2: id сессии, у одной карты может быть несколько сессий
+BOOST_CLASS_VERSION(::serialization::GameSessionRepr, 2)
@@ -0,0 +1,135 @@
+#pragma once
+
+#include "geom.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+namespace model {
+
+/*
+ *  Равномерная сетка над набором точек для выборки точек внутри круга.
+ *  Индексы точек хранятся подряд по ячейкам (cell_starts_ - начала ячеек),
+ *  размер ячейки подбирается так, чтобы в среднем на ячейку приходилась одна точка.
+ */
+class PointGrid {
+public:
+    PointGrid() = default;
+
+    explicit PointGrid(std::span<const geom::Point2D> points) {
+        if (points.empty()) {
+            return;
+        }
+
+        auto [min_x, max_x] = std::minmax_element(points.begin(), points.end(), [](const auto& a, const auto& b) {
+            return a.x < b.x;
+        });
+        auto [min_y, max_y] = std::minmax_element(points.begin(), points.end(), [](const auto& a, const auto& b) {
+            return a.y < b.y;
+        });
+
+        origin_ = {min_x->x, min_y->y};
+        const double width = max_x->x - min_x->x;
+        const double height = max_y->y - min_y->y;
+
+        cell_size_ = std::max(std::sqrt(width * height / static_cast<double>(points.size())), MIN_CELL_SIZE);
+        // Точки на одной линии дают нулевую площадь, поэтому число ячеек ограничивается отдельно
+        const size_t max_cells = std::max<size_t>(points.size() * 4, 1024);
+        for (;;) {
+            columns_ = static_cast<size_t>(width / cell_size_) + 1;
+            rows_ = static_cast<size_t>(height / cell_size_) + 1;
+            if (columns_ * rows_ <= max_cells) {
+                break;
+            }
+            cell_size_ *= 2;
+        }
+
+        std::vector<size_t> point_cells(points.size());
+        cell_starts_.assign(columns_ * rows_ + 1, 0);
+
+        for (size_t i = 0; i < points.size(); ++i) {
+            point_cells[i] = CellOf(points[i]);
+            ++cell_starts_[point_cells[i] + 1];
+        }
+        for (size_t cell = 1; cell < cell_starts_.size(); ++cell) {
+            cell_starts_[cell] += cell_starts_[cell - 1];
+        }
+
+        indices_.resize(points.size());
+        std::vector<size_t> fill(cell_starts_.begin(), cell_starts_.end() - 1);
+        for (size_t i = 0; i < points.size(); ++i) {
+            indices_[fill[point_cells[i]]++] = i;
+        }
+
+        points_.assign(points.begin(), points.end());
+    }
+
+    // Вызывает fn(index) для каждой точки не дальше radius от center
+    template <typename Fn>
+    void ForEachInRadius(geom::Point2D center, double radius, Fn&& fn) const {
+        if (indices_.empty() || radius < 0) {
+            return;
+        }
+
+        const auto [first_column, last_column] = Span(center.x - origin_.x, radius, columns_);
+        const auto [first_row, last_row] = Span(center.y - origin_.y, radius, rows_);
+        if (first_column > last_column || first_row > last_row) {
+            return;
+        }
+
+        const double sq_radius = radius * radius;
+
+        for (size_t row = first_row; row <= last_row; ++row) {
+            const size_t begin = cell_starts_[row * columns_ + first_column];
+            const size_t end = cell_starts_[row * columns_ + last_column + 1];
+
+            for (size_t i = begin; i < end; ++i) {
+                const auto& point = points_[indices_[i]];
+                const double dx = point.x - center.x;
+                const double dy = point.y - center.y;
+                if (dx * dx + dy * dy <= sq_radius) {
+                    fn(indices_[i]);
+                }
+            }
+        }
+    }
+
+private:
+    static constexpr double MIN_CELL_SIZE = 1.0;
+
+    struct CellRange {
+        size_t first;
+        size_t last;
+    };
+
+    // Диапазон ячеек по одной оси, пересекающий [offset - radius, offset + radius]
+    CellRange Span(double offset, double radius, size_t count) const {
+        const double lo = std::floor((offset - radius) / cell_size_);
+        const double hi = std::floor((offset + radius) / cell_size_);
+        if (hi < 0 || lo >= static_cast<double>(count)) {
+            return {1, 0};
+        }
+        // Границы ограничиваются до приведения к size_t: для огромного радиуса приведение неопределено
+        const double last = static_cast<double>(count - 1);
+        return {static_cast<size_t>(std::clamp(lo, 0.0, last)), static_cast<size_t>(std::clamp(hi, 0.0, last))};
+    }
+
+    size_t CellOf(const geom::Point2D& point) const {
+        const auto column = std::min(static_cast<size_t>((point.x - origin_.x) / cell_size_), columns_ - 1);
+        const auto row = std::min(static_cast<size_t>((point.y - origin_.y) / cell_size_), rows_ - 1);
+        return row * columns_ + column;
+    }
+
+    geom::Point2D origin_;
+    double cell_size_ = MIN_CELL_SIZE;
+    size_t columns_ = 0;
+    size_t rows_ = 0;
+    std::vector<size_t> cell_starts_;
+    std::vector<size_t> indices_;
+    std::vector<geom::Point2D> points_;
+};
+
+}  // namespace model
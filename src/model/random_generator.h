@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+#include <random>
+
+namespace util {
+
+/*
+ *  Быстрый генератор псевдослучайных чисел xoshiro256++.
+ *  Удовлетворяет требованиям UniformRandomBitGenerator, поэтому
+ *  используется со стандартными распределениями из <random>.
+ *  Состояние инициализируется из 64-битного зерна с помощью splitmix64.
+ */
+class Xoshiro256pp {
+public:
+    using result_type = std::uint64_t;
+
+    explicit Xoshiro256pp(std::uint64_t seed) noexcept {
+        Seed(seed);
+    }
+
+    // Зерно берётся из std::random_device
+    Xoshiro256pp()
+        : Xoshiro256pp(RandomSeed()) {
+    }
+
+    static constexpr result_type min() noexcept {
+        return std::numeric_limits<result_type>::min();
+    }
+
+    static constexpr result_type max() noexcept {
+        return std::numeric_limits<result_type>::max();
+    }
+
+    void Seed(std::uint64_t seed) noexcept {
+        for (auto& word : state_) {
+            seed += 0x9e3779b97f4a7c15ULL;
+            std::uint64_t z = seed;
+            z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+            z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+            word = z ^ (z >> 31);
+        }
+    }
+
+    result_type operator()() noexcept {
+        const std::uint64_t result = Rotl(state_[0] + state_[3], 23) + state_[0];
+        const std::uint64_t t = state_[1] << 17;
+
+        state_[2] ^= state_[0];
+        state_[3] ^= state_[1];
+        state_[1] ^= state_[2];
+        state_[0] ^= state_[3];
+
+        state_[2] ^= t;
+        state_[3] = Rotl(state_[3], 45);
+
+        return result;
+    }
+
+    static std::uint64_t RandomSeed() {
+        std::random_device rd;
+        return (static_cast<std::uint64_t>(rd()) << 32) ^ rd();
+    }
+
+private:
+    static constexpr std::uint64_t Rotl(std::uint64_t x, int k) noexcept {
+        return (x << k) | (x >> (64 - k));
+    }
+
+    std::uint64_t state_[4];
+};
+
+}  // namespace util
@@ -3,6 +3,7 @@
 
 #include <boost/json.hpp>
 
+#include <cmath>
 #include <regex>
 #include <iostream>
 
@@ -10,6 +11,157 @@ namespace http_handler {
 
 namespace json = boost::json;
 
+namespace {
+
+json::object PlayerStateToJson(const application::PlayerState& player_state) {
+    json::object player_json;
+
+    player_json[Properties::PLAYER_POSITION] = json::array{ player_state.position_x_, player_state.position_y_ };
+    player_json[Properties::PLAYER_SPEED] = json::array{ player_state.horizontal_speed_, player_state.vertical_speed_ };
+
+    player_json[Properties::PLAYER_DIRECTION] = player_state.dog_direction_;
+
+    auto json_bag = json::array{};
+
+    for (const auto& objects_in_bag : player_state.bag_) {
+        json::object object_in_bag;
+
+        object_in_bag[Properties::PLAYER_BAG_OBJ_ID] = objects_in_bag.id;
+        object_in_bag[Properties::PLAYER_BAG_OBJ_TYPE] = objects_in_bag.type;
+
+        json_bag.push_back(object_in_bag);
+    }
+
+    player_json[Properties::PLAYER_BAG] = json_bag;
+
+    player_json[Properties::PLAYER_SCORE] = player_state.score_;
+
+    return player_json;
+}
+
+json::object LootStateToJson(const model::LootState& loot) {
+    json::object lost_object;
+
+    lost_object[Properties::PLAYER_LOST_OBJECT_TYPE] = loot.type;
+    lost_object[Properties::PLAYER_LOST_OBJECT_POS] = json::array{ loot.position.x, loot.position.y };
+
+    return lost_object;
+}
+
+json::object MakeFullState(const application::SessionSnapshot* session) {
+    json::object response;
+    json::object players;
+
+    if (session) {
+        for (const auto& player_state : session->players_state_) {
+            players[player_state.dog_id_] = PlayerStateToJson(player_state);
+        }
+    }
+
+    response[Properties::PLAYERS_RESPONSE] = players;
+
+    if (session && !session->loots_state_.empty()) {
+
+        json::object lost_objects;
+
+        for (const auto& loot : session->loots_state_) {
+            // Ключ совпадает с id предмета в рюкзаке, по нему клиент находит подобранный трофей
+            lost_objects[std::to_string(loot.id)] = LootStateToJson(loot);
+        }
+
+        response[Properties::PLAYER_LOST_OBJECTS] = lost_objects;
+    }
+
+    return response;
+}
+
+// Собаки и трофеи не дальше radius от собаки игрока
+json::object MakeAreaState(const application::SessionSnapshot& session, const application::PlayerState& viewer, double radius) {
+    const geom::Point2D center{ viewer.position_x_, viewer.position_y_ };
+
+    json::object response;
+    json::object players;
+
+    session.GetPlayersGrid().ForEachInRadius(center, radius, [&](size_t index) {
+        const auto& player_state = session.players_state_[index];
+        players[player_state.dog_id_] = PlayerStateToJson(player_state);
+    });
+
+    response[Properties::PLAYERS_RESPONSE] = players;
+
+    json::object lost_objects;
+
+    session.GetLootGrid().ForEachInRadius(center, radius, [&](size_t index) {
+        const auto& loot = session.loots_state_[index];
+        lost_objects[std::to_string(loot.id)] = LootStateToJson(loot);
+    });
+
+    if (!lost_objects.empty()) {
+        response[Properties::PLAYER_LOST_OBJECTS] = lost_objects;
+    }
+
+    return response;
+}
+
+/*
+ *  Состояние сессии игрока, изменившееся после тика since.
+ *  Если клиент отстал больше, чем хранится история, или тик ему неизвестен,
+ *  возвращается полное состояние с признаком full.
+ */
+json::object MakeStateDelta(const application::SessionSnapshot& session, std::uint64_t since) {
+    const bool full = since < session.history_start_tick_ || since > session.tick_;
+
+    json::object response;
+    response[Properties::STATE_TICK] = session.tick_;
+    response[Properties::STATE_FULL] = full;
+
+    json::object players;
+    for (const auto& player_state : session.players_state_) {
+        if (full || player_state.changed_tick_ > since) {
+            players[player_state.dog_id_] = PlayerStateToJson(player_state);
+        }
+    }
+    response[Properties::PLAYERS_RESPONSE] = players;
+
+    json::object lost_objects;
+    for (size_t i = 0; i < session.loots_state_.size(); ++i) {
+        if (full || session.loot_spawn_ticks_[i] > since) {
+            const auto& loot = session.loots_state_[i];
+            lost_objects[std::to_string(loot.id)] = LootStateToJson(loot);
+        }
+    }
+    response[Properties::PLAYER_LOST_OBJECTS] = lost_objects;
+
+    if (!full) {
+        json::array removed_players;
+        json::array removed_lost_objects;
+
+        for (const auto& removals : session.removals_) {
+            if (removals.tick <= since) {
+                continue;
+            }
+            for (auto id : removals.dog_ids) {
+                removed_players.push_back(json::value(std::to_string(id)));
+            }
+            for (auto id : removals.loot_ids) {
+                removed_lost_objects.push_back(json::value(std::to_string(id)));
+            }
+        }
+
+        response[Properties::STATE_REMOVED_PLAYERS] = removed_players;
+        response[Properties::STATE_REMOVED_LOST_OBJECTS] = removed_lost_objects;
+    }
+
+    return response;
+}
+
+}  // namespace
+
+application::SessionSnapshot::BodyPtr MakeStateBody(const application::SessionSnapshot& session) {
+    return session.GetStateBody([&session] {
+        return PrettySerialize(MakeFullState(&session));
+    });
+}
 
 StringResponse APIRequestHandler::JoinToGame(const StringRequest& req)
 {
@@ -43,84 +195,80 @@ StringResponse APIRequestHandler::JoinToGame(const StringRequest& req)
     return MakeStringResponse(http::status::ok, json::serialize(response), req.version(), req.keep_alive());
 }
 
-StringResponse APIRequestHandler::GetPlayers(const StringRequest &req, const std::string_view token)
+StringResponse APIRequestHandler::GetPlayers(const StringRequest &req, const application::Token& token)
 {
     if (req.method() != http::verb::get && req.method() != http::verb::head)
         return MakeNotAlowedResponse("Invalid method"sv, "GET, HEAD"sv, req.version(), req.keep_alive());
 
     json::object response;
 
-    for (auto& player : app_.GetAllPlayers()) {
-        json::object player_json;
+    // Игроку видны только собаки его сессии
+    if (auto session = app_.GetState(token).session_) {
+        for (const auto& player_state : session->players_state_) {
+            json::object player_json;
 
-        player_json[Properties::USER_NAME] = player.GetDog()->GetName();
-        std::string id_key = std::to_string(*player.GetDog()->GetDogId());
+            player_json[Properties::USER_NAME] = player_state.name_;
 
-        response[id_key] = player_json;
+            response[player_state.dog_id_] = player_json;
+        }
     }
 
     return MakeStringResponse(http::status::ok, json::serialize(response), req.version(), req.keep_alive());
 }
 
-StringResponse APIRequestHandler::GetState(const StringRequest& req, const std::string_view token)
+StringResponse APIRequestHandler::GetState(const StringRequest& req, const application::Token& token)
 {
     if (req.method() != http::verb::get && req.method() != http::verb::head)
         return MakeNotAlowedResponse("Invalid method"sv, "GET, HEAD"sv, req.version(), req.keep_alive());
 
-    json::object response;
-    json::object players;
-
-    auto game_state = app_.GetState(token);
-
-    for (auto& palyer_state : game_state.players_state_) {
-
-        json::object player_json;
-
-        player_json[Properties::PLAYER_POSITION] = json::array{ palyer_state.position_x_, palyer_state.position_y_ };
-        player_json[Properties::PLAYER_SPEED] = json::array{ palyer_state.horizontal_speed_, palyer_state.vertical_speed_ };
+    const std::string_view target{req.target().data(), req.target().size()};
+    std::optional<std::uint64_t> since;
 
-        player_json[Properties::PLAYER_DIRECTION] = palyer_state.dog_direction_;
-
-        auto json_bag = json::array{};
-
-        for (const auto& objects_in_bag : palyer_state.bag_) {
-            json::object object_in_bag;
-
-            object_in_bag[Properties::PLAYER_BAG_OBJ_ID] = objects_in_bag.id;
-            object_in_bag[Properties::PLAYER_BAG_OBJ_TYPE] = objects_in_bag.type;
-
-            json_bag.push_back(object_in_bag);
+    if (auto param = FindQueryParameter(target, Properties::STATE_SINCE)) {
+        try {
+            since = std::stoull(std::string(*param));
+        } catch ([[maybe_unused]] const std::exception& e) {
+            return MakeBadRequest("invalidArgument"sv, "Invalid since tick"sv, req.version(), req.keep_alive());
         }
+    }
 
-        player_json[Properties::PLAYER_BAG] = json_bag;
+    std::optional<double> radius;
 
-        player_json[Properties::PLAYER_SCORE] = palyer_state.score_;
+    if (auto param = FindQueryParameter(target, Properties::STATE_RADIUS)) {
+        try {
+            radius = std::stod(std::string(*param));
+        } catch ([[maybe_unused]] const std::exception& e) {
+        }
 
-        players[palyer_state.dog_id_] = player_json;
+        if (!radius || !std::isfinite(*radius) || *radius < 0)
+            return MakeBadRequest("invalidArgument"sv, "Invalid radius"sv, req.version(), req.keep_alive());
     }
 
-    response[Properties::PLAYERS_RESPONSE] = players;
-
-    if (!game_state.loots_state_.empty()) {
-
-        json::object lost_objects;
+    // Изменения вне области видимости не отслеживаются, поэтому параметры несовместимы
+    if (since && radius)
+        return MakeBadRequest("invalidArgument"sv, "since and radius can not be combined"sv, req.version(), req.keep_alive());
 
-        for (size_t i = 0; i < game_state.loots_state_.size(); ++i) {
-            json::object lost_object;
+    auto game_state = app_.GetState(token);
 
-            lost_object[Properties::PLAYER_LOST_OBJECT_TYPE] = game_state.loots_state_[i].type;
-            lost_object[Properties::PLAYER_LOST_OBJECT_POS] = json::array{ game_state.loots_state_[i].position.x, game_state.loots_state_[i].position.y };
+    if (radius && game_state.session_ && game_state.player_) {
+        return MakeStringResponse(http::status::ok, PrettySerialize(MakeAreaState(*game_state.session_, *game_state.player_, *radius)), req.version(), req.keep_alive());
+    }
 
-            lost_objects[std::to_string(i)] = lost_object;
-        }
+    if (since && game_state.session_) {
+        return MakeStringResponse(http::status::ok, PrettySerialize(MakeStateDelta(*game_state.session_, *since)), req.version(), req.keep_alive());
+    }
 
-        response[Properties::PLAYER_LOST_OBJECTS] = lost_objects;
+    if (!game_state.session_) {
+        return MakeStringResponse(http::status::ok, PrettySerialize(MakeFullState(nullptr)), req.version(), req.keep_alive());
     }
 
-    return MakeStringResponse(http::status::ok, PrettySerialize(response), req.version(), req.keep_alive());
+    // Тело одинаково для всех игроков сессии, поэтому строится один раз на снимок сессии
+    auto body = MakeStateBody(*game_state.session_);
+
+    return MakeStringResponse(http::status::ok, *body, req.version(), req.keep_alive());
 }
 
-StringResponse APIRequestHandler::Action(const StringRequest& req, const std::string_view token)
+StringResponse APIRequestHandler::Action(const StringRequest& req, const application::Token& token)
 {
     if (req.method() != http::verb::post)
         return MakeNotAlowedResponse("Invalid method"sv, "POST"sv, req.version(), req.keep_alive());
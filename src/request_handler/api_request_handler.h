@@ -2,28 +2,16 @@
 
 #include "request_handler_helper.h"
 #include "application.h"
+#include "state_broadcaster.h"
+#include "http_headers.h"
 
 #include <functional>
-#include <regex>
 
 
 namespace http_handler {
 
-inline std::unordered_map<std::string, std::string> parseParameters(const std::string& uri) {
-    std::unordered_map<std::string, std::string> params;
-
-    std::regex paramRegex("(\\w+)=(\\w+)");
-    std::smatch match;
-
-    std::string::const_iterator searchStart(uri.cbegin());
-    while (std::regex_search(searchStart, uri.cend(), match, paramRegex)) {
-        params[match[1].str()] = match[2].str();
-        searchStart = match.suffix().first;
-    }
-
-    return params;
-}    
-
+// Тело полного ответа о состоянии сессии, строится один раз на снимок сессии
+application::SessionSnapshot::BodyPtr MakeStateBody(const application::SessionSnapshot& session);
 
 using Strand = net::strand<net::io_context::executor_type>;
 using HandlersMap = std::map<std::string_view, std::function<StringResponse(const StringRequest&)>>;
@@ -37,6 +25,11 @@ public:
     template <typename Body, typename Allocator, typename Send>
     void Handle(http::request<Body, http::basic_fields<Allocator>>&& req, Send&& send) {
 
+        // Читающие запросы работают со снимком мира и не ждут api strand
+        if (IsReadOnlyRequest(req.target())) {
+            return send(HandleAPIRequest(req));
+        }
+
         auto handle_api = [self = shared_from_this(), send,
             req = std::forward<decltype(req)>(req)] {
                 assert(self->api_strand_.running_in_this_thread());
@@ -46,9 +39,51 @@ public:
         return net::dispatch(api_strand_, handle_api);
     }
 
+    // Подписывает игрока на состояние его сессии через WebSocket.
+    // send отвечает на запрос ошибкой, accept принимает соединение и передаёт его в обработчик
+    template <typename Send, typename Accept>
+    void Upgrade(StringRequest&& req, Send&& send, Accept&& accept) {
+        const auto target = req.target();
+        if (target.substr(0, target.find('?')) != "/api/v1/game/state"sv || !state_broadcaster_)
+            return send(MakeBadRequest("badRequest"sv, "WebSocket is not supported for this resource"sv, req.version(), false));
+
+        // Браузер не передаёт заголовки при открытии WebSocket, поэтому токен можно указать в параметре token
+        std::optional<application::Token> token;
+        const auto auth_header = req[http::field::authorization];
+        const std::string_view authHeader{ auth_header.data(), auth_header.size() };
+        constexpr std::string_view BEARER = "Bearer "sv;
+
+        if (authHeader.starts_with(BEARER)) {
+            token = application::Token::FromHex(authHeader.substr(BEARER.size()));
+        }
+        else if (auto token_param = FindQueryParameter({target.data(), target.size()}, "token"sv)) {
+            token = application::Token::FromHex(*token_param);
+        }
+
+        if (!token)
+            return send(MakeUnauthorizedResponse("invalidToken"sv, "Player token is missing"sv, req.version(), false));
+
+        if (!app_.IsAuthorized(*token))
+            return send(MakeUnauthorizedResponse("unknownToken"sv, "Player token has not been found"sv, req.version(), false));
+
+        accept(std::move(req), [broadcaster = state_broadcaster_, token = *token](http_server::WebSocketSessionPtr connection) {
+            broadcaster->Subscribe(token, std::move(connection));
+        });
+    }
+
+    void SetStateBroadcaster(std::shared_ptr<StateBroadcaster> broadcaster) { state_broadcaster_ = std::move(broadcaster); }
+
     application::Application& GetApplication() { return app_; }
 
 private:
+    // Рекорды читаются через единственное соединение с БД, которое занимает и тик,
+    // поэтому они остаются в api strand и не блокируют потоки ввода-вывода
+    static bool IsReadOnlyRequest(std::string_view target) {
+        const auto path = target.substr(0, target.find('?'));
+        return path == "/api/v1/game/state"sv
+            || path == "/api/v1/game/players"sv;
+    }
+
     template <typename Body, typename Allocator>
     StringResponse HandleAPIRequest(const http::request<Body, http::basic_fields<Allocator>>& req) {
 
@@ -57,24 +92,25 @@ private:
         static auto get_state = std::bind(&APIRequestHandler::GetState, this, _1, _2);
         static auto action = std::bind(&APIRequestHandler::Action, this, _1, _2);
 
+        auto endp = std::string(req.target().begin(), req.target().end());
+        // Параметры запроса не участвуют в выборе обработчика
+        auto path = endp.substr(0, endp.find('?'));
+
         // TODO REFACTOR
-        if (std::string(req.target().begin(), req.target().end()) == "/api/v1/game/state")
+        if (path == "/api/v1/game/state")
         {
             if (req.method() != http::verb::get && req.method() != http::verb::head)
                 return MakeNotAlowedResponse("Invalid method"sv, "GET, HEAD"sv, req.version(), req.keep_alive());
         }
-        auto endp = std::string(req.target().begin(), req.target().end());
         if (endp.starts_with("/api/v1/game/records")) {
-            auto params = parseParameters(endp);
-
             std::optional<int> start;
-            if (params.count("start") > 0) {
-                start = std::stoi(params["start"]);
+            if (auto param = FindQueryParameter(endp, "start"sv)) {
+                start = std::stoi(std::string(*param));
             }
 
             std::optional<int> maxItems;
-            if (params.count("maxItems") > 0) {
-                maxItems = std::stoi(params["maxItems"]);
+            if (auto param = FindQueryParameter(endp, "maxItems"sv)) {
+                maxItems = std::stoi(std::string(*param));
             }
 
             if (maxItems && *maxItems > 100)
@@ -91,7 +127,7 @@ private:
 			{"/api/v1/game/tick"sv,   [this](const auto& req) { return this->Tick(req); }}
         };
 
-        auto handler_it = handlers.find(std::string(req.target().begin(), req.target().end()));
+        auto handler_it = handlers.find(path);
 
         if (handler_it == handlers.end())
             return MakeBadRequest("badRequest"sv, "Bad request"sv, req.version(), req.keep_alive());
@@ -102,30 +138,32 @@ private:
     template <typename Fn>
     StringResponse ExecuteAuthorized(Fn&& action, const StringRequest& req) {
 
-        std::string authHeader {req[http::field::authorization]};
-        static const std::string BEARER = "Bearer ";
-        const uint16_t TOKEN_LENGTH = 32;
+        // Заголовок разбирается на месте, без копирования строк
+        const auto auth_header = req[http::field::authorization];
+        const std::string_view authHeader{ auth_header.data(), auth_header.size() };
+        constexpr std::string_view BEARER = "Bearer "sv;
 
-        if (authHeader.empty() || !authHeader.starts_with(BEARER) || authHeader.substr(BEARER.length()).length() < TOKEN_LENGTH)
+        if (authHeader.empty() || !authHeader.starts_with(BEARER) || authHeader.size() - BEARER.size() < application::Token::HEX_LENGTH)
             return MakeUnauthorizedResponse("invalidToken"sv, "Authorization header is missing"sv, req.version(), req.keep_alive());
 
-        auto token = authHeader.substr(BEARER.length());
+        auto token = application::Token::FromHex(authHeader.substr(BEARER.size()));
 
-        if (!app_.IsAuthorized(token))
+        if (!token || !app_.IsAuthorized(*token))
             return MakeUnauthorizedResponse("unknownToken"sv, "Player token has not been found"sv, req.version(), req.keep_alive());
 
-        return action(req, token);
+        return action(req, *token);
     }
 
     StringResponse JoinToGame(const StringRequest& req);
-    StringResponse GetPlayers(const StringRequest &req, const std::string_view token);
-    StringResponse GetState(const StringRequest& req, const std::string_view token);
-    StringResponse Action(const StringRequest& req, const std::string_view token);
+    StringResponse GetPlayers(const StringRequest &req, const application::Token& token);
+    StringResponse GetState(const StringRequest& req, const application::Token& token);
+    StringResponse Action(const StringRequest& req, const application::Token& token);
     StringResponse Tick(const StringRequest& req);
     StringResponse GetRecords(const StringRequest& req, std::optional<int> start, std::optional<int> maxItems);
 
     application::Application& app_;
     Strand api_strand_;
+    std::shared_ptr<StateBroadcaster> state_broadcaster_;
 };
 
 }
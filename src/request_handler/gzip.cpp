@@ -0,0 +1,59 @@
+#include "gzip.h"
+
+#include <boost/beast/zlib/deflate_stream.hpp>
+#include <boost/crc.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <stdexcept>
+
+namespace http_handler {
+
+namespace {
+
+namespace zlib = boost::beast::zlib;
+
+// Заголовок без имени файла и времени модификации: максимальное сжатие, ОС Unix
+constexpr unsigned char GZIP_HEADER[] = {0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03};
+
+void AppendLittleEndian(std::string& out, std::uint32_t value) {
+    for (int i = 0; i < 4; ++i) {
+        out += static_cast<char>((value >> (8 * i)) & 0xFF);
+    }
+}
+
+}  // namespace
+
+std::string GzipCompress(std::string_view data) {
+    // deflate_stream выдаёт «сырой» deflate, заголовок и контрольную сумму gzip добавляем сами
+    zlib::deflate_stream deflate;
+    deflate.reset(9, 15, 8, zlib::Strategy::normal);
+
+    constexpr size_t HEADER_SIZE = sizeof(GZIP_HEADER);
+    std::string out(HEADER_SIZE + deflate.upper_bound(data.size()), '\0');
+    std::copy(std::begin(GZIP_HEADER), std::end(GZIP_HEADER), out.begin());
+
+    zlib::z_params params;
+    params.next_in = data.data();
+    params.avail_in = data.size();
+    params.next_out = out.data() + HEADER_SIZE;
+    params.avail_out = out.size() - HEADER_SIZE;
+
+    boost::beast::error_code ec;
+    deflate.write(params, zlib::Flush::finish, ec);
+    if (ec != zlib::error::end_of_stream) {
+        throw std::runtime_error("gzip compression failed: " + ec.message());
+    }
+    out.resize(HEADER_SIZE + params.total_out);
+
+    boost::crc_32_type crc;
+    crc.process_bytes(data.data(), data.size());
+
+    AppendLittleEndian(out, crc.checksum());
+    AppendLittleEndian(out, static_cast<std::uint32_t>(data.size()));
+
+    return out;
+}
+
+}  // namespace http_handler
@@ -0,0 +1,11 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace http_handler {
+
+// Сжимает data в формат gzip (RFC 1952) с максимальной степенью сжатия
+std::string GzipCompress(std::string_view data);
+
+}  // namespace http_handler
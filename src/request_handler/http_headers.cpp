@@ -0,0 +1,304 @@
+#include "http_headers.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <optional>
+
+namespace http_handler {
+
+namespace {
+
+std::string_view Trim(std::string_view value) {
+    const auto begin = value.find_first_not_of(" \t");
+    if (begin == std::string_view::npos) {
+        return {};
+    }
+    const auto end = value.find_last_not_of(" \t");
+    return value.substr(begin, end - begin + 1);
+}
+
+bool ParseNumber(std::string_view text, std::uint64_t& value) {
+    if (text.empty()) {
+        return false;
+    }
+    const auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(), value);
+    return ec == std::errc{} && ptr == text.data() + text.size();
+}
+
+bool EqualsIgnoreCase(std::string_view lhs, std::string_view rhs) {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(), [](char a, char b) {
+        return std::tolower(static_cast<unsigned char>(a)) == std::tolower(static_cast<unsigned char>(b));
+    });
+}
+
+// Значение q из параметров кодировки равно нулю
+bool HasZeroQuality(std::string_view params) {
+    while (!params.empty()) {
+        const auto separator = params.find(';');
+        const auto param = Trim(params.substr(0, separator));
+        params = separator == std::string_view::npos ? std::string_view{} : params.substr(separator + 1);
+
+        if (param.size() < 2 || std::tolower(static_cast<unsigned char>(param[0])) != 'q' || param[1] != '=') {
+            continue;
+        }
+
+        const auto value = Trim(param.substr(2));
+        return !value.empty() && value.find_first_not_of("0.") == std::string_view::npos;
+    }
+    return false;
+}
+
+constexpr std::string_view DAYS[] = {"Sun", "Mon", "Tue", "Wed", "Thu", "Fri", "Sat"};
+constexpr std::string_view MONTHS[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                       "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+
+bool ParseDigits(std::string_view text, int& value) {
+    value = 0;
+    for (char c : text) {
+        if (c < '0' || c > '9') {
+            return false;
+        }
+        value = value * 10 + (c - '0');
+    }
+    return !text.empty();
+}
+
+std::string FormatETag(std::uint64_t hi, std::optional<std::uint64_t> lo = std::nullopt) {
+    char buffer[48];
+    const int length = lo
+        ? std::snprintf(buffer, sizeof(buffer), "\"%llx-%llx\"", static_cast<unsigned long long>(hi), static_cast<unsigned long long>(*lo))
+        : std::snprintf(buffer, sizeof(buffer), "\"%016llx\"", static_cast<unsigned long long>(hi));
+    return std::string(buffer, length);
+}
+
+}  // namespace
+
+bool AcceptsGzip(std::string_view accept_encoding) {
+    std::optional<bool> gzip;
+    std::optional<bool> any;
+
+    while (!accept_encoding.empty()) {
+        const auto separator = accept_encoding.find(',');
+        const auto item = accept_encoding.substr(0, separator);
+        accept_encoding = separator == std::string_view::npos ? std::string_view{} : accept_encoding.substr(separator + 1);
+
+        const auto params_start = item.find(';');
+        const auto coding = Trim(item.substr(0, params_start));
+        const bool accepted = params_start == std::string_view::npos || !HasZeroQuality(item.substr(params_start + 1));
+
+        if (EqualsIgnoreCase(coding, "gzip") || EqualsIgnoreCase(coding, "x-gzip")) {
+            gzip = accepted;
+        }
+        else if (coding == "*") {
+            any = accepted;
+        }
+    }
+
+    return gzip.value_or(any.value_or(false));
+}
+
+RangeRequest ParseRange(std::string_view header, std::uint64_t size) {
+    using Status = RangeRequest::Status;
+    constexpr std::string_view BYTES = "bytes=";
+
+    header = Trim(header);
+    if (!header.starts_with(BYTES)) {
+        return {};
+    }
+
+    const auto spec = Trim(header.substr(BYTES.size()));
+    const auto dash = spec.find('-');
+    // Несколько диапазонов потребовали бы multipart-ответа, такой запрос получает файл целиком
+    if (dash == std::string_view::npos || spec.find(',') != std::string_view::npos) {
+        return {};
+    }
+
+    const auto first_text = Trim(spec.substr(0, dash));
+    const auto last_text = Trim(spec.substr(dash + 1));
+
+    if (first_text.empty()) {
+        // bytes=-n - последние n байт
+        std::uint64_t suffix = 0;
+        if (!ParseNumber(last_text, suffix)) {
+            return {};
+        }
+        if (suffix == 0 || size == 0) {
+            return {Status::UNSATISFIABLE};
+        }
+        suffix = std::min(suffix, size);
+        return {Status::SATISFIABLE, {size - suffix, suffix}};
+    }
+
+    std::uint64_t first = 0;
+    if (!ParseNumber(first_text, first)) {
+        return {};
+    }
+
+    std::uint64_t last = size == 0 ? 0 : size - 1;
+    if (!last_text.empty()) {
+        if (!ParseNumber(last_text, last) || last < first) {
+            return {};
+        }
+    }
+
+    if (first >= size) {
+        return {Status::UNSATISFIABLE};
+    }
+    last = std::min(last, size - 1);
+
+    return {Status::SATISFIABLE, {first, last - first + 1}};
+}
+
+std::chrono::sys_seconds ToSysSeconds(std::filesystem::file_time_type time) {
+    return std::chrono::floor<std::chrono::seconds>(std::chrono::file_clock::to_sys(time));
+}
+
+std::string FormatHttpDate(std::filesystem::file_time_type time) {
+    const std::time_t timestamp = std::chrono::system_clock::to_time_t(ToSysSeconds(time));
+
+    std::tm tm{};
+    gmtime_r(&timestamp, &tm);
+
+    // Названия дней и месяцев не зависят от локали
+    char buffer[32];
+    const int length = std::snprintf(buffer, sizeof(buffer), "%s, %02d %s %04d %02d:%02d:%02d GMT",
+                                     DAYS[tm.tm_wday].data(), tm.tm_mday, MONTHS[tm.tm_mon].data(),
+                                     tm.tm_year + 1900, tm.tm_hour, tm.tm_min, tm.tm_sec);
+
+    return std::string(buffer, length);
+}
+
+std::optional<std::chrono::sys_seconds> ParseHttpDate(std::string_view date) {
+    using namespace std::chrono;
+
+    // "Sun, 06 Nov 1994 08:49:37 GMT"
+    date = Trim(date);
+    if (date.size() != 29 || date.substr(3, 2) != ", " || date.substr(25) != " GMT"
+        || date[7] != ' ' || date[11] != ' ' || date[16] != ' ' || date[19] != ':' || date[22] != ':') {
+        return std::nullopt;
+    }
+
+    const auto month_it = std::find(std::begin(MONTHS), std::end(MONTHS), date.substr(8, 3));
+    if (month_it == std::end(MONTHS)) {
+        return std::nullopt;
+    }
+
+    int day = 0, year = 0, hours = 0, minutes = 0, secs = 0;
+    if (!ParseDigits(date.substr(5, 2), day) || !ParseDigits(date.substr(12, 4), year)
+        || !ParseDigits(date.substr(17, 2), hours) || !ParseDigits(date.substr(20, 2), minutes)
+        || !ParseDigits(date.substr(23, 2), secs)) {
+        return std::nullopt;
+    }
+
+    const year_month_day ymd{std::chrono::year{year},
+                             std::chrono::month{static_cast<unsigned>(month_it - std::begin(MONTHS) + 1)},
+                             std::chrono::day{static_cast<unsigned>(day)}};
+    if (!ymd.ok() || hours > 23 || minutes > 59 || secs > 60) {
+        return std::nullopt;
+    }
+
+    return sys_days{ymd} + hours * 1h + minutes * 1min + secs * 1s;
+}
+
+std::string MakeETag(std::string_view content) {
+    // FNV-1a не зависит от реализации стандартной библиотеки, поэтому тег не меняется после перезапуска
+    std::uint64_t hash = 0xcbf29ce484222325ULL;
+    for (unsigned char c : content) {
+        hash = (hash ^ c) * 0x100000001b3ULL;
+    }
+    return FormatETag(hash);
+}
+
+std::string MakeFileETag(std::uint64_t size, std::filesystem::file_time_type last_write_time) {
+    const auto ticks = last_write_time.time_since_epoch().count();
+    return FormatETag(size, static_cast<std::uint64_t>(ticks));
+}
+
+std::string MakeGzipETag(std::string_view etag) {
+    if (etag.size() < 2) {
+        return std::string(etag);
+    }
+    std::string gzip_etag(etag.substr(0, etag.size() - 1));
+    gzip_etag += "-gzip\"";
+    return gzip_etag;
+}
+
+bool MatchesETag(std::string_view if_none_match, std::string_view etag) {
+    if (etag.empty()) {
+        return false;
+    }
+
+    while (!if_none_match.empty()) {
+        const auto separator = if_none_match.find(',');
+        auto tag = Trim(if_none_match.substr(0, separator));
+        if_none_match = separator == std::string_view::npos ? std::string_view{} : if_none_match.substr(separator + 1);
+
+        if (tag == "*") {
+            return true;
+        }
+        if (tag.starts_with("W/")) {
+            tag.remove_prefix(2);
+        }
+        if (tag == etag) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::optional<std::string_view> FindQueryParameter(std::string_view target, std::string_view name) {
+    const auto query_start = target.find('?');
+    if (query_start == std::string_view::npos) {
+        return std::nullopt;
+    }
+
+    auto query = target.substr(query_start + 1);
+    while (!query.empty()) {
+        const auto separator = query.find('&');
+        const auto parameter = query.substr(0, separator);
+        query = separator == std::string_view::npos ? std::string_view{} : query.substr(separator + 1);
+
+        const auto equals = parameter.find('=');
+        if (parameter.substr(0, equals) == name) {
+            return equals == std::string_view::npos ? std::string_view{} : parameter.substr(equals + 1);
+        }
+    }
+    return std::nullopt;
+}
+
+std::string RedactQueryParameter(std::string_view target, std::string_view name) {
+    auto query_start = target.find('?');
+    if (query_start == std::string_view::npos) {
+        return std::string(target);
+    }
+
+    std::string redacted(target.substr(0, ++query_start));
+    auto query = target.substr(query_start);
+
+    while (true) {
+        const auto separator = query.find('&');
+        const auto parameter = query.substr(0, separator);
+
+        const auto key = parameter.substr(0, parameter.find('='));
+        if (key == name) {
+            redacted.append(key);
+            redacted += "=***";
+        }
+        else {
+            redacted.append(parameter);
+        }
+
+        if (separator == std::string_view::npos) {
+            break;
+        }
+        redacted += '&';
+        query.remove_prefix(separator + 1);
+    }
+    return redacted;
+}
+
+}  // namespace http_handler
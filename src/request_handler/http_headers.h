@@ -0,0 +1,67 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <string>
+#include <string_view>
+
+namespace http_handler {
+
+// Участок файла [offset, offset + length)
+struct ByteRange {
+    std::uint64_t offset = 0;
+    std::uint64_t length = 0;
+};
+
+struct RangeRequest {
+    enum class Status {
+        // Заголовка нет или он не задаёт один диапазон байт - файл отдаётся целиком
+        NONE,
+        SATISFIABLE,
+        // Диапазон за пределами файла - ответ 416
+        UNSATISFIABLE
+    };
+
+    Status status = Status::NONE;
+    ByteRange range;
+};
+
+// Разбирает значение заголовка Range для файла размером size.
+// Поддерживается один диапазон вида bytes=a-b, bytes=a- или bytes=-n
+RangeRequest ParseRange(std::string_view header, std::uint64_t size);
+
+// Допускает ли значение заголовка Accept-Encoding ответ в gzip.
+// Кодировка с q=0 запрещена, явное упоминание gzip важнее "*"
+bool AcceptsGzip(std::string_view accept_encoding);
+
+// Время файла с точностью до секунд, как в заголовке Last-Modified
+std::chrono::sys_seconds ToSysSeconds(std::filesystem::file_time_type time);
+
+// Дата в формате HTTP, например "Sun, 06 Nov 1994 08:49:37 GMT"
+std::string FormatHttpDate(std::filesystem::file_time_type time);
+
+// Разбирает дату в формате IMF-fixdate, устаревшие форматы не поддерживаются
+std::optional<std::chrono::sys_seconds> ParseHttpDate(std::string_view date);
+
+// Сильный ETag по хешу содержимого
+std::string MakeETag(std::string_view content);
+
+// ETag файла, который не читается целиком: по размеру и времени модификации
+std::string MakeFileETag(std::uint64_t size, std::filesystem::file_time_type last_write_time);
+
+// ETag сжатого gzip варианта ресурса с тегом etag
+std::string MakeGzipETag(std::string_view etag);
+
+// Содержит ли значение If-None-Match тег etag. Признак слабого тега W/ не учитывается
+bool MatchesETag(std::string_view if_none_match, std::string_view etag);
+
+// Значение параметра name из строки запроса адреса target, без декодирования.
+// Для параметра без "=" возвращается пустая строка
+std::optional<std::string_view> FindQueryParameter(std::string_view target, std::string_view name);
+
+// Адрес запроса, в котором значение параметра name заменено на "***", например токен для журнала
+std::string RedactQueryParameter(std::string_view target, std::string_view name);
+
+}  // namespace http_handler
@@ -3,22 +3,6 @@
 
 namespace http_handler {
 
-StringResponse RequestHandler::GetAllMaps(unsigned int http_version, bool keep_alive)
-{
-    json::array response;
-
-    for (const auto& map : app_.GetMaps())
-    {
-        json::object map_item;
-        map_item[Properties::MAP_ID] = *map.GetId();
-        map_item[Properties::MAP_NAME] = map.GetName();
-
-        response.push_back(map_item);
-    }
-    
-    return MakeStringResponse(http::status::ok, PrettySerialize(response), http_version, keep_alive);
-}
-
 void FillRoads(const model::Map& model_map, json::object& map_json) {
     json::array roads_json_arr;
     for (auto& road : model_map.GetRoads())
@@ -94,35 +78,102 @@ void FillLootTypes(const model::Map& model_map, json::object& map_json) {
     map_json[Properties::LOOT_TYPES_ARRAY] = lootTypes_json_arr;
 }
 
-StringResponse RequestHandler::GetMapById(std::string_view id, unsigned int http_version, bool keep_alive) {
-    
-    const auto* model_map_p = app_.FindMap(id);
+void RequestHandler::CacheMapBodies() {
+    json::array maps_json;
+
+    for (const auto& map : app_.GetMaps())
+    {
+        json::object map_item;
+        map_item[Properties::MAP_ID] = *map.GetId();
+        map_item[Properties::MAP_NAME] = map.GetName();
+
+        maps_json.push_back(map_item);
+
+        json::object map_json;
+
+        map_json[Properties::MAP_ID] = *map.GetId();
+        map_json[Properties::MAP_NAME] = map.GetName();
+
+        FillRoads(map, map_json);
+        FillBuildings(map, map_json);
+        FillOffices(map, map_json);
+        FillLootTypes(map, map_json);
 
-    if (!model_map_p)
+        auto body = PrettySerialize(map_json);
+        auto etag = MakeETag(body);
+        maps_.emplace(*map.GetId(), CachedBody{std::move(body), std::move(etag)});
+    }
+
+    all_maps_.body = PrettySerialize(maps_json);
+    all_maps_.etag = MakeETag(all_maps_.body);
+}
+
+StringResponse RequestHandler::GetAllMaps(std::string_view if_none_match, unsigned int http_version, bool keep_alive) const
+{
+    return MakeMapsResponse(all_maps_, if_none_match, http_version, keep_alive);
+}
+
+StringResponse RequestHandler::GetMapById(std::string_view id, std::string_view if_none_match, unsigned int http_version, bool keep_alive) const {
+
+    auto it = maps_.find(std::string(id));
+
+    if (it == maps_.end())
         return MakeNotFoundResponse("mapNotFound"sv, "Map not found"sv, http_version, keep_alive);
 
-    json::object map_json;
+    return MakeMapsResponse(it->second, if_none_match, http_version, keep_alive);
+}
+
+StringResponse RequestHandler::MakeMapsResponse(const CachedBody& body, std::string_view if_none_match, unsigned int http_version, bool keep_alive) const {
 
-    map_json[Properties::MAP_ID] = *model_map_p->GetId();
-    map_json[Properties::MAP_NAME] = model_map_p->GetName();
+    // Ответ с no-cache клиент может хранить, но перед использованием сверяет ETag
+    if (MatchesETag(if_none_match, body.etag))
+        return MakeNotModified(FileHeaders{{}, body.etag, {}, CACHE_CONTROL_REVALIDATE}, http_version, keep_alive);
 
-    FillRoads(*model_map_p, map_json);
-    FillBuildings(*model_map_p, map_json);
-    FillOffices(*model_map_p, map_json);
-    FillLootTypes(*model_map_p, map_json);
+    auto response = MakeStringResponse(http::status::ok, body.body, http_version, keep_alive);
+    response.set(http::field::etag, body.etag);
 
-    return MakeStringResponse(http::status::ok, PrettySerialize(map_json), http_version, keep_alive);
-}    
+    return response;
+}
+
+StringResponse RequestHandler::MakeNotModified(const FileHeaders& headers, unsigned int http_version, bool keep_alive) const {
+    StringResponse response(http::status::not_modified, http_version);
+    SetValidatorHeaders(response, headers);
+    response.keep_alive(keep_alive);
+
+    return response;
+}
+
+SharedStringResponse RequestHandler::MakeCachedFileResponse(const StaticFileCache::File& file, const FileHeaders& headers, const RangeRequest& range,
+                                                            unsigned int http_version, bool keep_alive) const {
+    const auto& data = headers.gzip ? file.gzip_content : file.content;
+
+    std::string_view content = *data;
+    if (range.status == RangeRequest::Status::SATISFIABLE)
+        content = content.substr(range.range.offset, range.range.length);
+
+    SharedStringResponse response(http::status::ok, http_version);
+    SetFileHeaders(response, headers, range, data->size());
+    response.body() = {data, content};
+    response.content_length(content.size());
+    response.keep_alive(keep_alive);
+
+    return response;
+}
 
 std::string RequestHandler::PercentDecode(const std::string& uri) const {
-    
-    std::stringstream ss;
+
+    // Большинство путей не содержат экранированных символов
+    if (uri.find('%') == std::string::npos)
+        return uri;
+
+    std::string decoded;
+    decoded.reserve(uri.size());
 
     for (auto cur_it = uri.begin(); cur_it != uri.end(); ++cur_it)
     {
         if (*cur_it != '%')
         {
-            ss << *cur_it;
+            decoded += *cur_it;
             continue;
         }
 
@@ -141,14 +192,14 @@ std::string RequestHandler::PercentDecode(const std::string& uri) const {
 			if (decoded_char < 0 && decoded_char > 255)
 				return {};
 			
-			ss << static_cast<char>(decoded_char);
+			decoded += static_cast<char>(decoded_char);
 			
 		} catch ([[maybe_unused]] const std::invalid_argument& e) {
 			return {};
 		}
     }
 
-    return ss.str();
+    return decoded;
 }
 
 std::string_view RequestHandler::ExtesionToContentType(const std::string& extension) const {
@@ -4,6 +4,8 @@
 #include "model.h"
 #include "logger_helper.h"
 #include "api_request_handler.h"
+#include "static_file_cache.h"
+#include "http_headers.h"
 
 #include <filesystem>
 
@@ -19,6 +21,7 @@ public:
         : root_path_{root_path}
         , api_request_handler_{api_handler}
         , app_(api_handler->GetApplication()) {
+        CacheMapBodies();
     }
 
     RequestHandler(const RequestHandler&) = delete;
@@ -41,21 +44,34 @@ public:
                 if (req.method() != http::verb::get && req.method() != http::verb::head)
                     return send(MakeNotAlowedResponse("Invalid method"sv, "GET, HEAD"sv, req.version(), req.keep_alive()));
 
+                const auto if_none_match = req[http::field::if_none_match];
+                const std::string_view if_none_match_view{if_none_match.data(), if_none_match.size()};
+
                 auto tokens = SplitUriPath(resource_type);
                 // /maps or /map/map_id
                 if (tokens.size() != 2)
-                    return send(GetAllMaps(req.version(), req.keep_alive()));
+                    return send(GetAllMaps(if_none_match_view, req.version(), req.keep_alive()));
 
-                return send(GetMapById(tokens[1], req.version(), req.keep_alive()));
+                return send(GetMapById(tokens[1], if_none_match_view, req.version(), req.keep_alive()));
             }
 
             return api_request_handler_->Handle(std::forward<decltype(req)>(req), std::forward<decltype(send)>(send));
         }
 
-        std::string decoded_uri = PercentDecode(target);
+        // Параметры запроса не входят в путь к файлу. Ресурс с параметром v версионирован:
+        // при изменении файла меняется ссылка на него, поэтому его можно кэшировать надолго
+        const auto query_start = target.find('?');
+        const bool versioned = query_start != std::string::npos && FindQueryParameter(target, "v"sv).has_value();
+        const std::string_view cache_control = versioned ? CACHE_CONTROL_IMMUTABLE : CACHE_CONTROL_REVALIDATE;
+
+        std::string decoded_uri = PercentDecode(target.substr(0, query_start));
 
         assert(!decoded_uri.empty());
 
+        // Часто запрашиваемые файлы отдаются из памяти без обращения к файловой системе
+        if (auto file = static_cache_.Find(decoded_uri))
+            return SendCachedFile(*file, req, cache_control, std::forward<Send>(send));
+
         fs::path requested_path = root_path_;
 
         if (decoded_uri == "/")
@@ -72,7 +88,7 @@ public:
             return send(response);
         }
 
-        if (!fs::exists(requested_path))
+        if (!fs::is_regular_file(requested_path))
         {
             StringResponse response;
             response.result(http::status::not_found);
@@ -81,23 +97,185 @@ public:
             return send(response);
         }
 
-        http::file_body::value_type file;
+        const auto content_type = ExtesionToContentType(requested_path.extension().generic_string());
+
+        if (auto file = static_cache_.Load(decoded_uri, requested_path, content_type))
+            return SendCachedFile(*file, req, cache_control, std::forward<Send>(send));
+
+        std::error_code time_ec;
+        const auto last_write_time = fs::last_write_time(requested_path, time_ec);
+        const std::string last_modified = time_ec ? std::string{} : FormatHttpDate(last_write_time);
+
+        // Большие файлы не сжимаются на лету, но заранее собранный файл .gz отдаётся, если клиент его примет
+        const auto gzip_path = time_ec ? std::nullopt : FindGzipSibling(requested_path, last_write_time);
+        const bool gzip = gzip_path && IsGzipAccepted(req);
+
+        FileResponse::body_type::value_type file;
         boost::system::error_code ec;
 
-        file.open(requested_path.generic_string().c_str(), beast::file_mode::read, ec);
+        file.file.open((gzip ? *gzip_path : requested_path).generic_string().c_str(), beast::file_mode::read, ec);
+        const std::uint64_t size = ec ? 0 : file.file.size(ec);
+
+        std::string etag;
+        if (!ec && !time_ec)
+            etag = gzip ? MakeGzipETag(MakeFileETag(size, last_write_time)) : MakeFileETag(size, last_write_time);
+
+        const FileHeaders headers{content_type, etag, last_modified, cache_control, gzip_path.has_value(), gzip};
+
+        if (!time_ec && IsNotModified(req, etag, ToSysSeconds(last_write_time)))
+            return send(MakeNotModified(headers, req.version(), req.keep_alive()));
+
+        const auto range = GetRequestedRange(req, size, etag, last_modified);
+        if (range.status == RangeRequest::Status::UNSATISFIABLE)
+            return send(MakeRangeNotSatisfiable(size, req.version(), req.keep_alive()));
+
+        const bool partial = range.status == RangeRequest::Status::SATISFIABLE;
+        file.offset = partial ? range.range.offset : 0;
+        file.length = partial ? range.range.length : size;
 
-        FileResponse file_response;
+        FileResponse file_response(http::status::ok, req.version());
 
-        file_response.insert(http::field::content_type, ExtesionToContentType(requested_path.extension().generic_string()));
+        SetFileHeaders(file_response, headers, range, size);
         file_response.body() = std::move(file);
+        file_response.keep_alive(req.keep_alive());
         file_response.prepare_payload();
 
         return send(file_response);
     }
 
+    // Запрос на открытие WebSocket. Через WebSocket доступно только API
+    template <typename Send, typename Accept>
+    void Upgrade(StringRequest&& req, Send&& send, Accept&& accept) {
+        if (!req.target().starts_with("/api/v1/"sv))
+            return send(MakeBadRequest("badRequest"sv, "WebSocket is not supported for this resource"sv, req.version(), false));
+
+        return api_request_handler_->Upgrade(std::move(req), std::forward<Send>(send), std::forward<Accept>(accept));
+    }
+
+    // Ёмкость кэша статических файлов в байтах, 0 отключает кэш
+    void SetStaticCacheCapacity(size_t capacity) { static_cache_.SetCapacity(capacity); }
+
 private:
-    StringResponse GetAllMaps(unsigned int http_version, bool keep_alive);
-    StringResponse GetMapById(std::string_view id, unsigned int http_version, bool keep_alive);
+    // Версионированный ресурс не меняется, остальные проверяются по ETag при каждом использовании
+    static constexpr std::string_view CACHE_CONTROL_IMMUTABLE = "public, max-age=31536000, immutable"sv;
+    static constexpr std::string_view CACHE_CONTROL_REVALIDATE = "no-cache"sv;
+
+    // Заголовки ответа с файлом, общие для 200, 206 и 304
+    struct FileHeaders {
+        std::string_view content_type;
+        std::string_view etag;
+        std::string_view last_modified;
+        std::string_view cache_control;
+        // У файла есть сжатый вариант, поэтому ответ зависит от Accept-Encoding
+        bool has_gzip = false;
+        bool gzip = false;
+    };
+
+    // Тело ответа из памяти, ETag вычисляется один раз
+    struct CachedBody {
+        std::string body;
+        std::string etag;
+    };
+
+    template <typename Request, typename Send>
+    void SendCachedFile(const StaticFileCache::File& file, const Request& req, std::string_view cache_control, Send&& send) const {
+        const bool gzip = file.gzip_content && IsGzipAccepted(req);
+        const FileHeaders headers{file.content_type, gzip ? file.gzip_etag : file.etag, file.last_modified, cache_control,
+                                  file.gzip_content != nullptr, gzip};
+
+        if (IsNotModified(req, headers.etag, ToSysSeconds(file.last_write_time)))
+            return send(MakeNotModified(headers, req.version(), req.keep_alive()));
+
+        const auto range = GetRequestedRange(req, file.content->size(), file.etag, file.last_modified);
+        if (range.status == RangeRequest::Status::UNSATISFIABLE)
+            return send(MakeRangeNotSatisfiable(file.content->size(), req.version(), req.keep_alive()));
+
+        return send(MakeCachedFileResponse(file, headers, range, req.version(), req.keep_alive()));
+    }
+
+    // Сжатый вариант отдаётся только целиком, запрос диапазона получает исходный файл
+    template <typename Request>
+    static bool IsGzipAccepted(const Request& req) {
+        const auto accept_encoding = req[http::field::accept_encoding];
+        return req[http::field::range].empty() && AcceptsGzip({accept_encoding.data(), accept_encoding.size()});
+    }
+
+    // If-None-Match проверяется по ETag, а при его отсутствии If-Modified-Since - по времени изменения
+    template <typename Request>
+    static bool IsNotModified(const Request& req, std::string_view etag, std::chrono::sys_seconds modified_at) {
+        if (req.method() != http::verb::get && req.method() != http::verb::head)
+            return false;
+
+        const auto if_none_match = req[http::field::if_none_match];
+        if (!if_none_match.empty())
+            return MatchesETag({if_none_match.data(), if_none_match.size()}, etag);
+
+        const auto if_modified_since = req[http::field::if_modified_since];
+        if (if_modified_since.empty())
+            return false;
+
+        const auto since = ParseHttpDate({if_modified_since.data(), if_modified_since.size()});
+        return since && modified_at <= *since;
+    }
+
+    // Запрошенный участок файла. If-Range отменяет Range, если файл изменился:
+    // значение сравнивается с ETag исходного файла или с датой Last-Modified
+    template <typename Request>
+    static RangeRequest GetRequestedRange(const Request& req, std::uint64_t size, std::string_view etag, std::string_view last_modified) {
+        const auto range = req[http::field::range];
+        if (range.empty() || req.method() != http::verb::get)
+            return {};
+
+        const std::string_view if_range{req[http::field::if_range].data(), req[http::field::if_range].size()};
+        if (!if_range.empty()) {
+            const auto& validator = if_range.starts_with('"') ? etag : last_modified;
+            if (validator.empty() || if_range != validator)
+                return {};
+        }
+
+        return ParseRange({range.data(), range.size()}, size);
+    }
+
+    template <typename Response>
+    static void SetFileHeaders(Response& response, const FileHeaders& headers, const RangeRequest& range, std::uint64_t size) {
+        response.set(http::field::content_type, headers.content_type);
+        response.set(http::field::accept_ranges, "bytes"sv);
+        SetValidatorHeaders(response, headers);
+
+        if (headers.gzip)
+            response.set(http::field::content_encoding, "gzip"sv);
+
+        if (range.status == RangeRequest::Status::SATISFIABLE) {
+            const auto last = range.range.offset + range.range.length - 1;
+            response.result(http::status::partial_content);
+            response.set(http::field::content_range,
+                         "bytes " + std::to_string(range.range.offset) + "-" + std::to_string(last) + "/" + std::to_string(size));
+        }
+    }
+
+    // Заголовки, которые повторяются в ответе 304
+    template <typename Response>
+    static void SetValidatorHeaders(Response& response, const FileHeaders& headers) {
+        if (!headers.etag.empty())
+            response.set(http::field::etag, headers.etag);
+
+        if (!headers.last_modified.empty())
+            response.set(http::field::last_modified, headers.last_modified);
+
+        response.set(http::field::cache_control, headers.cache_control);
+
+        if (headers.has_gzip)
+            response.set(http::field::vary, "Accept-Encoding"sv);
+    }
+
+    StringResponse MakeNotModified(const FileHeaders& headers, unsigned int http_version, bool keep_alive) const;
+    StringResponse MakeMapsResponse(const CachedBody& body, std::string_view if_none_match, unsigned int http_version, bool keep_alive) const;
+    void CacheMapBodies();
+
+    SharedStringResponse MakeCachedFileResponse(const StaticFileCache::File& file, const FileHeaders& headers, const RangeRequest& range,
+                                                unsigned int http_version, bool keep_alive) const;
+    StringResponse GetAllMaps(std::string_view if_none_match, unsigned int http_version, bool keep_alive) const;
+    StringResponse GetMapById(std::string_view id, std::string_view if_none_match, unsigned int http_version, bool keep_alive) const;
     std::string PercentDecode(const std::string& uri) const;
     std::string_view ExtesionToContentType(const std::string& extension) const;
     bool IsSubPath(fs::path path, fs::path base) const;
@@ -105,6 +283,10 @@ private:
     fs::path root_path_;
     std::shared_ptr<APIRequestHandler> api_request_handler_;
     application::Application& app_;
+    StaticFileCache static_cache_;
+    // Карты не меняются во время работы, поэтому ответы о них строятся при запуске
+    CachedBody all_maps_;
+    std::unordered_map<std::string, CachedBody> maps_;
 };
 
 class DurationMeasure {
@@ -133,7 +315,8 @@ public:
 
         json::object request_data;
         request_data["ip"s] = ip;
-        request_data["URI"s] = std::string(req.target());
+        // Токен из параметра запроса WebSocket не должен попасть в журнал
+        request_data["URI"s] = RedactQueryParameter({req.target().data(), req.target().size()}, "token"sv);
         request_data["method"s] = std::string(req.method_string());
 
         BOOST_LOG_TRIVIAL(info) << logging::add_value(additional_data, request_data)
@@ -169,6 +352,20 @@ public:
         });
     }
 
+    template <typename Send, typename Accept>
+    void Upgrade(StringRequest&& req, Send&& send, Accept&& accept, const std::string& ip) {
+
+        LogRequest(req, ip);
+
+        // Ответ логируется, только если соединение отклонено
+        auto timer = std::make_shared<DurationMeasure>();
+        decorated_.Upgrade(std::move(req), [send_ = std::forward<Send>(send), ip, timer](auto&& resp)
+        {
+            LogResponse(resp, ip, timer->GetDurationInMilliseconds());
+            send_(resp);
+        }, std::forward<Accept>(accept));
+    }
+
 private:
      SomeRequestHandler& decorated_;
 };
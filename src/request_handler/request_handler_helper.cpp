@@ -44,6 +44,15 @@ StringResponse MakeUnauthorizedResponse(const std::string_view code, const std::
     return MakeErrorResponse(http::status::unauthorized, code, message, http_version, keep_alive);
 }
 
+StringResponse MakeRangeNotSatisfiable(std::uint64_t size, unsigned int http_version, bool keep_alive)
+{
+    StringResponse response(http::status::range_not_satisfiable, http_version);
+    response.set(http::field::content_range, "bytes */" + std::to_string(size));
+    response.content_length(0);
+    response.keep_alive(keep_alive);
+    return response;
+}
+
 void PrettyPrint( std::ostream& os, json::value const& jv, std::string* indent) {
     std::string indent_;
     if(!indent)
@@ -15,7 +15,49 @@ using StringRequest = http::request<http::string_body>;
 // Ответ, тело которого представлено в виде строки
 using StringResponse = http::response<http::string_body>;
 
-using FileResponse = http::response<http::file_body>;
+using FileResponse = http::response<http_server::SendfileBody>;
+
+// Тело из участка разделяемой неизменяемой строки: ответы отправляют один буфер без копирования
+struct SharedStringBody {
+    struct value_type {
+        std::shared_ptr<const std::string> data;
+        // Отправляемая часть data
+        std::string_view content;
+    };
+
+    static std::uint64_t size(const value_type& body) {
+        return body.content.size();
+    }
+
+    class writer {
+    public:
+        using const_buffers_type = net::const_buffer;
+
+        template <bool isRequest, class Fields>
+        writer([[maybe_unused]] const http::header<isRequest, Fields>& header, const value_type& body)
+            : body_(body) {
+        }
+
+        void init(beast::error_code& ec) {
+            ec = {};
+        }
+
+        boost::optional<std::pair<const_buffers_type, bool>> get(beast::error_code& ec) {
+            ec = {};
+            if (sent_ || body_.content.empty()) {
+                return boost::none;
+            }
+            sent_ = true;
+            return {{net::const_buffer(body_.content.data(), body_.content.size()), false}};
+        }
+
+    private:
+        const value_type& body_;
+        bool sent_ = false;
+    };
+};
+
+using SharedStringResponse = http::response<SharedStringBody>;
 
 StringResponse MakeStringResponse(const http::status status, const std::string_view body, unsigned int http_version, bool keep_alive);
 StringResponse MakeErrorResponse(const http::status status, const std::string_view code, const std::string_view message, unsigned int http_version, bool keep_alive);
@@ -24,6 +66,7 @@ StringResponse MakeBadRequest(const std::string_view code, const std::string_vie
 StringResponse MakeNotAlowedResponse(const std::string_view message, const std::string_view allow, unsigned int http_version, bool keep_alive);
 StringResponse MakeNotFoundResponse(const std::string_view code, const std::string_view message, unsigned int http_version, bool keep_alive);
 StringResponse MakeUnauthorizedResponse(const std::string_view code, const std::string_view message, unsigned int http_version, bool keep_alive);
+StringResponse MakeRangeNotSatisfiable(std::uint64_t size, unsigned int http_version, bool keep_alive);
 
 void PrettyPrint( std::ostream& os, json::value const& jv, std::string* indent = nullptr );
 std::string PrettySerialize(json::value const& jv);
@@ -0,0 +1,43 @@
+#include "state_broadcaster.h"
+#include "api_request_handler.h"
+
+namespace http_handler {
+
+void StateBroadcaster::Subscribe(const application::Token& token, http_server::WebSocketSessionPtr connection) {
+    if (!Push(token, *connection)) {
+        return connection->Close();
+    }
+
+    std::lock_guard lock{mutex_};
+    subscribers_.push_back({token, connection});
+}
+
+void StateBroadcaster::OnUpdate([[maybe_unused]] const std::chrono::milliseconds& delta) {
+    std::lock_guard lock{mutex_};
+    std::erase_if(subscribers_, [this](const Subscriber& subscriber) {
+        auto connection = subscriber.connection.lock();
+        if (!connection || !connection->IsOpen()) {
+            return true;
+        }
+
+        if (!Push(subscriber.token, *connection)) {
+            connection->Close();
+            return true;
+        }
+        return false;
+    });
+}
+
+bool StateBroadcaster::Push(const application::Token& token, http_server::WebSocketSession& connection) {
+    if (!app_.IsAuthorized(token)) {
+        return false;
+    }
+
+    // Сессия игрока может ещё не попасть в снимок, тогда ждём следующего тика
+    if (auto state = app_.GetState(token); state.session_) {
+        connection.Send(MakeStateBody(*state.session_));
+    }
+    return true;
+}
+
+}  // namespace http_handler
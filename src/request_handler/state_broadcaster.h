@@ -0,0 +1,43 @@
+#pragma once
+
+#include "http_server.h"
+#include "application.h"
+#include "application_listener.h"
+
+#include <mutex>
+#include <vector>
+
+namespace http_handler {
+
+/*
+ *  Рассылает состояние сессии игрокам, подписанным через WebSocket.
+ *  После каждого тика подписчик получает то же тело, что и на GET /api/v1/game/state;
+ *  тело строится один раз на снимок сессии и разделяется всеми её подписчиками.
+ *  Соединения игроков, покинувших игру, закрываются.
+ */
+class StateBroadcaster : public IApplicationlListener {
+public:
+    explicit StateBroadcaster(application::Application& app)
+        : app_(app) {
+    }
+
+    // Можно вызывать из любого потока. Подписчик сразу получает текущее состояние
+    void Subscribe(const application::Token& token, http_server::WebSocketSessionPtr connection);
+
+    void OnUpdate(const std::chrono::milliseconds& delta) override;
+
+private:
+    struct Subscriber {
+        application::Token token;
+        std::weak_ptr<http_server::WebSocketSession> connection;
+    };
+
+    // Отправляет состояние сессии игрока, false если игрок больше не в игре
+    bool Push(const application::Token& token, http_server::WebSocketSession& connection);
+
+    application::Application& app_;
+    std::mutex mutex_;
+    std::vector<Subscriber> subscribers_;
+};
+
+}  // namespace http_handler
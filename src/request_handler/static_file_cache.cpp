@@ -0,0 +1,196 @@
+#include "static_file_cache.h"
+#include "http_headers.h"
+#include "gzip.h"
+
+#include <fstream>
+#include <iterator>
+
+namespace http_handler {
+
+namespace {
+
+// Один файл занимает не больше этой доли кэша, чтобы не вытеснять все остальные
+constexpr size_t MAX_FILE_SHARE = 4;
+// Выигрыш от сжатия файлов меньшего размера не окупает заголовок Content-Encoding
+constexpr size_t MIN_GZIP_SIZE = 1024;
+
+bool IsCompressible(std::string_view content_type) {
+    return content_type.starts_with("text/")
+        || content_type == "application/json"
+        || content_type == "application/xml"
+        || content_type == "image/svg+xml";
+}
+
+std::optional<std::string> ReadFile(const fs::path& path, size_t size_hint) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        return std::nullopt;
+    }
+
+    std::string content;
+    content.reserve(size_hint);
+    content.assign(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>());
+    if (input.bad()) {
+        return std::nullopt;
+    }
+    return content;
+}
+
+std::shared_ptr<const std::string> MakeGzipContent(const StaticFileCache::File& file) {
+    if (auto sibling = FindGzipSibling(file.path, file.last_write_time)) {
+        if (auto gzip = ReadFile(*sibling, file.content->size())) {
+            return std::make_shared<const std::string>(std::move(*gzip));
+        }
+    }
+
+    if (file.content->size() < MIN_GZIP_SIZE || !IsCompressible(file.content_type)) {
+        return nullptr;
+    }
+
+    auto gzip = GzipCompress(*file.content);
+    // Уже сжатые данные только увеличились бы
+    if (gzip.size() >= file.content->size()) {
+        return nullptr;
+    }
+    return std::make_shared<const std::string>(std::move(gzip));
+}
+
+size_t MemorySize(const StaticFileCache::File& file) {
+    return file.content->size() + (file.gzip_content ? file.gzip_content->size() : 0);
+}
+
+}  // namespace
+
+std::optional<fs::path> FindGzipSibling(const fs::path& path, fs::file_time_type last_write_time) {
+    auto sibling = path;
+    sibling += ".gz";
+
+    std::error_code ec;
+    if (!fs::is_regular_file(sibling, ec)) {
+        return std::nullopt;
+    }
+    const auto sibling_write_time = fs::last_write_time(sibling, ec);
+    if (ec || sibling_write_time < last_write_time) {
+        return std::nullopt;
+    }
+    return sibling;
+}
+
+void StaticFileCache::SetCapacity(size_t capacity) {
+    std::lock_guard lock{mutex_};
+    capacity_ = capacity;
+    Evict();
+}
+
+size_t StaticFileCache::GetCapacity() const {
+    std::lock_guard lock{mutex_};
+    return capacity_;
+}
+
+size_t StaticFileCache::GetSize() const {
+    std::lock_guard lock{mutex_};
+    return size_;
+}
+
+StaticFileCache::FilePtr StaticFileCache::Find(const std::string& key, Clock::time_point now) {
+    FilePtr file;
+    {
+        std::lock_guard lock{mutex_};
+
+        auto index_it = index_.find(key);
+        if (index_it == index_.end()) {
+            return nullptr;
+        }
+
+        auto it = index_it->second;
+        entries_.splice(entries_.begin(), entries_, it);
+
+        if (now - it->checked_at < CHECK_INTERVAL) {
+            return it->file;
+        }
+        // Пока файл проверяется, остальные запросы получают его без повторной проверки
+        it->checked_at = now;
+        file = it->file;
+    }
+
+    // Обращения к диску выполняются без блокировки, чтобы не задерживать другие запросы
+    std::error_code ec;
+    const auto last_write_time = fs::last_write_time(file->path, ec);
+    const auto size = ec ? 0 : fs::file_size(file->path, ec);
+
+    if (!ec && last_write_time == file->last_write_time && size == file->content->size()) {
+        return file;
+    }
+
+    std::lock_guard lock{mutex_};
+    // За время проверки запись могли перезагрузить или вытеснить
+    if (auto index_it = index_.find(key); index_it != index_.end() && index_it->second->file == file) {
+        Erase(index_it->second);
+    }
+    return nullptr;
+}
+
+StaticFileCache::FilePtr StaticFileCache::Load(const std::string& key, const fs::path& path,
+                                               std::string_view content_type, Clock::time_point now) {
+    const size_t capacity = GetCapacity();
+    if (capacity == 0) {
+        return nullptr;
+    }
+
+    // Время модификации берётся до чтения: если файл изменится во время чтения,
+    // следующая проверка заметит расхождение и перечитает его
+    std::error_code ec;
+    if (!fs::is_regular_file(path, ec)) {
+        return nullptr;
+    }
+    const auto last_write_time = fs::last_write_time(path, ec);
+    const auto size = ec ? 0 : fs::file_size(path, ec);
+    if (ec || size > capacity / MAX_FILE_SHARE) {
+        return nullptr;
+    }
+
+    auto content = ReadFile(path, size);
+    if (!content) {
+        return nullptr;
+    }
+
+    auto file = std::make_shared<File>();
+    file->path = path;
+    file->content = std::make_shared<const std::string>(std::move(*content));
+    file->content_type = content_type;
+    file->last_write_time = last_write_time;
+    file->last_modified = FormatHttpDate(last_write_time);
+    file->gzip_content = MakeGzipContent(*file);
+    // Тег тот же, что у файла, отданного мимо кэша, поэтому вытеснение не сбивает If-None-Match
+    file->etag = MakeFileETag(file->content->size(), last_write_time);
+    if (file->gzip_content) {
+        file->gzip_etag = MakeGzipETag(file->etag);
+    }
+
+    std::lock_guard lock{mutex_};
+
+    if (auto it = index_.find(key); it != index_.end()) {
+        Erase(it->second);
+    }
+
+    entries_.push_front({key, file, now});
+    index_.emplace(key, entries_.begin());
+    size_ += MemorySize(*file);
+    Evict();
+
+    return file;
+}
+
+void StaticFileCache::Erase(Entries::iterator it) {
+    size_ -= MemorySize(*it->file);
+    index_.erase(it->key);
+    entries_.erase(it);
+}
+
+void StaticFileCache::Evict() {
+    while (size_ > capacity_ && !entries_.empty()) {
+        Erase(std::prev(entries_.end()));
+    }
+}
+
+}  // namespace http_handler
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <chrono>
+#include <filesystem>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace http_handler {
+
+namespace fs = std::filesystem;
+
+// Заранее сжатый файл path.gz, если он есть и не старше path
+std::optional<fs::path> FindGzipSibling(const fs::path& path, fs::file_time_type last_write_time);
+
+/*
+ *  LRU-кэш статических файлов в памяти, ключ - декодированный путь запроса.
+ *  Суммарный размер файлов не превышает ёмкости, при нехватке места вытесняются
+ *  давно не запрашивавшиеся файлы. Файл перечитывается, если изменились время
+ *  модификации или размер; диск проверяется не чаще CHECK_INTERVAL для каждого файла.
+ *  Текстовые файлы хранятся и в сжатом gzip виде: сжатие выполняется один раз при
+ *  загрузке файла в кэш, если рядом нет заранее собранного файла .gz.
+ *  Методы можно вызывать из любого потока.
+ */
+class StaticFileCache {
+public:
+    using Clock = std::chrono::steady_clock;
+
+    struct File {
+        fs::path path;
+        std::shared_ptr<const std::string> content;
+        // Указывает на статическую строку с типом содержимого
+        std::string_view content_type;
+        fs::file_time_type last_write_time;
+        // Значение заголовка Last-Modified
+        std::string last_modified;
+        // Содержимое, сжатое gzip, или nullptr, если сжатие не уменьшает файл
+        std::shared_ptr<const std::string> gzip_content;
+        // ETag исходного и сжатого содержимого, по размеру и времени модификации, как у файлов вне кэша
+        std::string etag;
+        std::string gzip_etag;
+    };
+
+    using FilePtr = std::shared_ptr<const File>;
+
+    static constexpr Clock::duration CHECK_INTERVAL = std::chrono::seconds{1};
+
+    // Ёмкость в байтах, 0 отключает кэш
+    void SetCapacity(size_t capacity);
+    size_t GetCapacity() const;
+    // Суммарный размер файлов в кэше вместе со сжатыми вариантами
+    size_t GetSize() const;
+
+    // Файл из кэша или nullptr, если его нет или он изменился на диске
+    FilePtr Find(const std::string& key, Clock::time_point now = Clock::now());
+
+    // Читает файл path и сохраняет его под ключом key.
+    // Возвращает nullptr, если файл не читается или слишком велик для кэша
+    FilePtr Load(const std::string& key, const fs::path& path, std::string_view content_type,
+                 Clock::time_point now = Clock::now());
+
+private:
+    struct Entry {
+        std::string key;
+        FilePtr file;
+        Clock::time_point checked_at;
+    };
+
+    using Entries = std::list<Entry>;
+
+    void Erase(Entries::iterator it);
+    void Evict();
+
+    mutable std::mutex mutex_;
+    // Недавно запрошенные файлы в начале списка
+    Entries entries_;
+    std::unordered_map<std::string, Entries::iterator> index_;
+    size_t capacity_ = 0;
+    size_t size_ = 0;
+};
+
+}  // namespace http_handler
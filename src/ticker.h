@@ -1,25 +1,45 @@
 #pragma once
 
+#include <boost/asio/basic_waitable_timer.hpp>
+#include <boost/asio/dispatch.hpp>
 #include <boost/asio/io_context.hpp>
+#include <boost/asio/strand.hpp>
+
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <functional>
+#include <memory>
 
 namespace net = boost::asio;
 namespace sys = boost::system;
 
-class Ticker : public std::enable_shared_from_this<Ticker> {
+// Clock задаётся параметром шаблона, чтобы в тестах подменять время
+template <typename Clock = std::chrono::steady_clock>
+class BasicTicker : public std::enable_shared_from_this<BasicTicker<Clock>> {
 public:
     using Strand = net::strand<net::io_context::executor_type>;
     using Handler = std::function<void(std::chrono::milliseconds delta)>;
 
     // Функция handler будет вызываться внутри strand с интервалом period
-    Ticker(Strand strand, std::chrono::milliseconds period, Handler handler)
+    BasicTicker(Strand strand, std::chrono::milliseconds period, Handler handler)
         : strand_{strand}
         , period_{period}
         , handler_{std::move(handler)} {
     }
 
+    // Режим фиксированного шага: handler всегда получает delta == period,
+    // а накопившееся время отрабатывается несколькими шагами за одно пробуждение.
+    // max_catch_up_steps ограничивает число шагов при перегрузке, остаток отбрасывается.
+    // Должен вызываться до Start
+    void SetFixedStep(unsigned max_catch_up_steps) {
+        max_catch_up_steps_ = std::max(1u, max_catch_up_steps);
+    }
+
     void Start() {
-        net::dispatch(strand_, [self = shared_from_this()] {
+        net::dispatch(strand_, [self = this->shared_from_this()] {
             self->last_tick_ = Clock::now();
+            self->next_deadline_ = self->last_tick_ + self->period_;
             self->ScheduleTick();
         });
     }
@@ -27,8 +47,10 @@ public:
 private:
     void ScheduleTick() {
         assert(strand_.running_in_this_thread());
-        timer_.expires_after(period_);
-        timer_.async_wait([self = shared_from_this()](sys::error_code ec) {
+        // Пробуждения планируются по абсолютным моментам времени,
+        // поэтому длительность обработчика не сдвигает следующие тики
+        timer_.expires_at(next_deadline_);
+        timer_.async_wait([self = this->shared_from_this()](sys::error_code ec) {
             self->OnTick(ec);
         });
     }
@@ -39,21 +61,58 @@ private:
 
         if (!ec) {
             auto this_tick = Clock::now();
-            auto delta = duration_cast<milliseconds>(this_tick - last_tick_);
-            last_tick_ = this_tick;
-            try {
-                handler_(delta);
-            } catch (...) {
+
+            if (max_catch_up_steps_ > 0) {
+                RunFixedSteps(this_tick - last_tick_);
+                last_tick_ = this_tick;
+            } else {
+                auto delta = duration_cast<milliseconds>(this_tick - last_tick_);
+                // Отбрасываемая при округлении часть миллисекунды войдёт в следующий тик
+                last_tick_ += delta;
+                try {
+                    handler_(delta);
+                } catch (...) {
+                }
+            }
+
+            next_deadline_ += period_;
+            if (next_deadline_ <= this_tick) {
+                // Пропущенные пробуждения не нагоняем, время уже учтено в delta
+                next_deadline_ = this_tick + period_;
             }
             ScheduleTick();
         }
     }
 
-    using Clock = std::chrono::steady_clock;
+    void RunFixedSteps(typename Clock::duration elapsed) {
+        accumulator_ += elapsed;
+
+        unsigned steps = 0;
+        while (accumulator_ >= period_ && steps < max_catch_up_steps_) {
+            accumulator_ -= period_;
+            ++steps;
+            try {
+                handler_(period_);
+            } catch (...) {
+            }
+        }
+
+        if (accumulator_ >= period_) {
+            // Не успеваем за реальным временем - отбрасываем отставание,
+            // чтобы не уйти в спираль догоняющих шагов
+            accumulator_ %= typename Clock::duration{period_};
+        }
+    }
 
     Strand strand_;
     std::chrono::milliseconds period_;
-    net::steady_timer timer_{strand_};
+    net::basic_waitable_timer<Clock> timer_{strand_};
     Handler handler_;
-    std::chrono::steady_clock::time_point last_tick_;
-}; 
\ No newline at end of file
+    typename Clock::time_point last_tick_;
+    typename Clock::time_point next_deadline_;
+    typename Clock::duration accumulator_{};
+    // 0 - режим переменного шага
+    unsigned max_catch_up_steps_ = 0;
+};
+
+using Ticker = BasicTicker<>;
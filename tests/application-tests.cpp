@@ -0,0 +1,168 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/application/application.h"
+#include "../src/application/parallel_for.h"
+#include "memory-records.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+constexpr size_t PLAYERS_COUNT = 8;
+constexpr auto TICK = 100ms;
+constexpr double RETIREMENT_TIME = 5000.0;
+
+// Одна карта с трофеями и офисом, в каждой сессии не больше двух игроков
+void SetUpGame(model::Game& game) {
+    model::Map map(model::Map::Id("map1"), "Map 1");
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 20});
+    map.AddRoad(model::Road{model::Road::VERTICAL, {20, 0}, 20});
+    map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 20}, 20});
+    map.AddLootType(model::LootType{"key", "assets/key.obj", "obj", 90, "#338844", 0.03});
+    map.AddLootType(model::LootType{"wallet", "assets/wallet.obj", "obj", 90, "#338899", 0.01});
+    map.AddOffice(model::Office{model::Office::Id("o1"), {20, 20}, {0, 0}});
+
+    game.AddMap(map);
+    game.SetLootGeneratorConfig({500, 0.5});
+    game.SetDogRetirementTime(RETIREMENT_TIME);
+    game.SetMaxPlayersPerSession(2);
+    game.SetRandomSeed(42);
+}
+
+std::vector<application::Token> JoinPlayers(application::Application& app) {
+    std::vector<application::Token> tokens;
+    for (size_t i = 0; i < PLAYERS_COUNT; ++i) {
+        tokens.push_back(*application::Token::FromHex(app.JoinToGame("dog" + std::to_string(i), "map1").first));
+    }
+    return tokens;
+}
+
+void CheckSameState(const application::GameState& lhs, const application::GameState& rhs) {
+    REQUIRE(static_cast<bool>(lhs.player_) == static_cast<bool>(rhs.player_));
+    if (!lhs.player_) {
+        return;
+    }
+
+    CHECK(lhs.player_->position_x_ == rhs.player_->position_x_);
+    CHECK(lhs.player_->position_y_ == rhs.player_->position_y_);
+    CHECK(lhs.player_->horizontal_speed_ == rhs.player_->horizontal_speed_);
+    CHECK(lhs.player_->vertical_speed_ == rhs.player_->vertical_speed_);
+    CHECK(lhs.player_->score_ == rhs.player_->score_);
+    CHECK(lhs.player_->bag_ == rhs.player_->bag_);
+    CHECK(lhs.session_->tick_ == rhs.session_->tick_);
+    CHECK(lhs.session_->loots_state_ == rhs.session_->loots_state_);
+}
+
+std::vector<std::string> RecordNames(const test_utils::MemoryRecords& records) {
+    std::vector<std::string> names;
+    for (const auto& record : records.GetAll()) {
+        names.push_back(record.name);
+    }
+    return names;
+}
+
+}  // namespace
+
+SCENARIO("Updating game sessions in parallel") {
+
+    GIVEN("the same game updated in one thread and in a thread pool") {
+        model::Game serial_game;
+        SetUpGame(serial_game);
+        test_utils::MemoryRecords serial_records;
+        application::Application serial_app{serial_game, serial_records, true};
+
+        model::Game parallel_game;
+        SetUpGame(parallel_game);
+        test_utils::MemoryRecords parallel_records;
+        application::Application parallel_app{parallel_game, parallel_records, true};
+        parallel_app.SetTickThreads(4);
+
+        const auto serial_tokens = JoinPlayers(serial_app);
+        const auto parallel_tokens = JoinPlayers(parallel_app);
+        REQUIRE(serial_game.GetSessions().size() == PLAYERS_COUNT / 2);
+
+        WHEN("half of the players move until everyone retires") {
+            constexpr std::string_view DIRECTIONS = "LRUD";
+            for (size_t i = 0; i < PLAYERS_COUNT; i += 2) {
+                serial_app.Move(serial_tokens[i], DIRECTIONS[i / 2 % DIRECTIONS.size()]);
+                parallel_app.Move(parallel_tokens[i], DIRECTIONS[i / 2 % DIRECTIONS.size()]);
+            }
+
+            THEN("both games publish the same state after every tick and retire players in the same order") {
+                for (int tick = 0; tick < 300; ++tick) {
+                    serial_app.UpdateGameState(TICK);
+                    parallel_app.UpdateGameState(TICK);
+
+                    for (size_t i = 0; i < PLAYERS_COUNT; ++i) {
+                        CheckSameState(serial_app.GetState(serial_tokens[i]), parallel_app.GetState(parallel_tokens[i]));
+                    }
+                }
+
+                CHECK(serial_records.GetAll().size() == PLAYERS_COUNT);
+                CHECK(RecordNames(parallel_records) == RecordNames(serial_records));
+                for (size_t i = 0; i < std::min(serial_records.GetAll().size(), parallel_records.GetAll().size()); ++i) {
+                    CHECK(parallel_records.GetAll()[i].score == serial_records.GetAll()[i].score);
+                    CHECK(parallel_records.GetAll()[i].play_time == serial_records.GetAll()[i].play_time);
+                }
+            }
+        }
+
+        WHEN("nobody moves and all players retire on the same tick") {
+            for (int tick = 0; tick < static_cast<int>(RETIREMENT_TIME / TICK.count()); ++tick) {
+                serial_app.UpdateGameState(TICK);
+                parallel_app.UpdateGameState(TICK);
+            }
+
+            THEN("records follow the session order in both games") {
+                std::vector<std::string> expected;
+                for (size_t i = 0; i < PLAYERS_COUNT; ++i) {
+                    expected.push_back("dog" + std::to_string(i));
+                }
+
+                CHECK(RecordNames(serial_records) == expected);
+                CHECK(RecordNames(parallel_records) == expected);
+                CHECK(parallel_game.GetSessions().empty());
+            }
+        }
+    }
+}
+
+SCENARIO("Running tasks in a thread pool") {
+
+    GIVEN("a thread pool") {
+        boost::asio::thread_pool pool{4};
+        constexpr size_t TASKS_COUNT = 16;
+        std::vector<int> calls(TASKS_COUNT, 0);
+
+        WHEN("all tasks succeed") {
+            application::ParallelFor(pool, TASKS_COUNT, [&calls](size_t i) {
+                ++calls[i];
+            });
+
+            THEN("every task runs once") {
+                CHECK(calls == std::vector<int>(TASKS_COUNT, 1));
+            }
+        }
+
+        WHEN("some tasks throw") {
+            auto run = [&] {
+                application::ParallelFor(pool, TASKS_COUNT, [&calls](size_t i) {
+                    ++calls[i];
+                    if (i == 5 || i == 11) {
+                        throw std::runtime_error("task " + std::to_string(i));
+                    }
+                });
+            };
+
+            THEN("the other tasks still run and the error of the first failed task is rethrown") {
+                CHECK_THROWS_WITH(run(), "task 5");
+                CHECK(calls == std::vector<int>(TASKS_COUNT, 1));
+            }
+        }
+    }
+}
@@ -2,6 +2,7 @@
 
 #include <cmath>
 #include <functional>
+#include <random>
 #include <sstream>
 
 #include <catch2/catch_test_macros.hpp>
@@ -181,4 +182,92 @@ SCENARIO("Collision detection") {
             CHECK(events.empty());
         }
     }
-}
\ No newline at end of file
+    WHEN("many items and gatherers") {
+        std::mt19937 gen{42};
+        std::uniform_real_distribution<double> coord(-50., 50.);
+        std::uniform_real_distribution<double> step(-3., 3.);
+        std::uniform_real_distribution<double> width(0., 0.6);
+
+        std::vector<collision_detector::Item> items;
+        for (int i = 0; i < 500; ++i) {
+            items.push_back({{coord(gen), coord(gen)}, width(gen)});
+        }
+        std::vector<collision_detector::Gatherer> gatherers;
+        for (int i = 0; i < 100; ++i) {
+            geom::Point2D start{coord(gen), coord(gen)};
+            gatherers.push_back({start, {start.x + step(gen), start.y + step(gen)}, width(gen)});
+        }
+        // Длинный отрезок через всю карту
+        gatherers.push_back({{-60, -60}, {60, 60}, 0.6});
+
+        VectorItemGathererProvider provider{items, gatherers};
+
+        THEN("events match the brute force search") {
+            std::vector<collision_detector::GatheringEvent> expected;
+            for (size_t g = 0; g < gatherers.size(); ++g) {
+                for (size_t i = 0; i < items.size(); ++i) {
+                    auto result = collision_detector::TryCollectPoint(
+                        gatherers[g].start_pos, gatherers[g].end_pos, items[i].position);
+                    if (result.IsCollected(gatherers[g].width + items[i].width)) {
+                        expected.push_back({i, g, result.sq_distance, result.proj_ratio});
+                    }
+                }
+            }
+            std::sort(expected.begin(), expected.end(), [](const auto& l, const auto& r) {
+                return l.time < r.time;
+            });
+
+            auto events = collision_detector::FindGatherEvents(provider);
+            REQUIRE(!expected.empty());
+            CHECK_THAT(events, EqualsRange(expected, CompareEvents()));
+        }
+    }
+}
+
+SCENARIO("Batched point collection") {
+    GIVEN("a gatherer and a batch of items") {
+        std::mt19937 gen{7};
+        std::uniform_real_distribution<double> coord(-5., 5.);
+        std::uniform_real_distribution<double> width(0., 1.);
+
+        collision_detector::ItemsBatch batch;
+        // Размер не кратен ширине вектора, чтобы проверить и хвост
+        for (int i = 0; i < 1003; ++i) {
+            batch.Add({{coord(gen), coord(gen)}, width(gen)});
+        }
+        // Предметы на концах отрезка и на границе радиуса
+        batch.Add({{0, 0}, 0.});
+        batch.Add({{3, 0}, 0.});
+        batch.Add({{1, 0.5}, 0.});
+
+        const collision_detector::Gatherer gatherer{{0, 0}, {3, 0}, 0.5};
+
+        WHEN("items are tested in a batch") {
+            collision_detector::BatchCollectionResult batched;
+            collision_detector::TryCollectPoints(gatherer, batch, batched);
+
+            collision_detector::BatchCollectionResult scalar;
+            collision_detector::TryCollectPointsScalar(gatherer, batch, scalar);
+
+            THEN("results match the scalar kernel lane by lane") {
+                REQUIRE(batched.collected.size() == batch.Size());
+                CHECK(batched.collected == scalar.collected);
+                CHECK(batched.sq_distance == scalar.sq_distance);
+                CHECK(batched.proj_ratio == scalar.proj_ratio);
+            }
+
+            THEN("results match TryCollectPoint") {
+                for (size_t i = 0; i < batch.Size(); ++i) {
+                    auto expected = collision_detector::TryCollectPoint(
+                        gatherer.start_pos, gatherer.end_pos, {batch.x[i], batch.y[i]});
+
+                    INFO("item: " << i);
+                    REQUIRE(static_cast<bool>(batched.collected[i])
+                            == expected.IsCollected(gatherer.width + batch.width[i]));
+                    REQUIRE(batched.sq_distance[i] == expected.sq_distance);
+                    REQUIRE(batched.proj_ratio[i] == expected.proj_ratio);
+                }
+            }
+        }
+    }
+}
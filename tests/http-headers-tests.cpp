@@ -0,0 +1,178 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/request_handler/http_headers.h"
+
+#include <chrono>
+
+using namespace std::literals;
+
+SCENARIO("Range header") {
+    using http_handler::ParseRange;
+    using Status = http_handler::RangeRequest::Status;
+
+    GIVEN("a file of 1000 bytes") {
+        constexpr std::uint64_t SIZE = 1000;
+
+        THEN("closed, open and suffix ranges are supported") {
+            auto closed = ParseRange("bytes=100-199"sv, SIZE);
+            CHECK(closed.status == Status::SATISFIABLE);
+            CHECK(closed.range.offset == 100);
+            CHECK(closed.range.length == 100);
+
+            auto open = ParseRange("bytes=900-"sv, SIZE);
+            CHECK(open.status == Status::SATISFIABLE);
+            CHECK(open.range.offset == 900);
+            CHECK(open.range.length == 100);
+
+            auto suffix = ParseRange("bytes=-10"sv, SIZE);
+            CHECK(suffix.status == Status::SATISFIABLE);
+            CHECK(suffix.range.offset == 990);
+            CHECK(suffix.range.length == 10);
+        }
+
+        THEN("ranges past the end of the file are clipped") {
+            auto clipped = ParseRange("bytes=500-5000"sv, SIZE);
+            CHECK(clipped.status == Status::SATISFIABLE);
+            CHECK(clipped.range.length == 500);
+
+            auto long_suffix = ParseRange("bytes=-5000"sv, SIZE);
+            CHECK(long_suffix.status == Status::SATISFIABLE);
+            CHECK(long_suffix.range.offset == 0);
+            CHECK(long_suffix.range.length == SIZE);
+        }
+
+        THEN("a range starting past the end can not be satisfied") {
+            CHECK(ParseRange("bytes=1000-"sv, SIZE).status == Status::UNSATISFIABLE);
+            CHECK(ParseRange("bytes=-0"sv, SIZE).status == Status::UNSATISFIABLE);
+        }
+
+        THEN("malformed and multiple ranges are ignored") {
+            CHECK(ParseRange(""sv, SIZE).status == Status::NONE);
+            CHECK(ParseRange("items=0-10"sv, SIZE).status == Status::NONE);
+            CHECK(ParseRange("bytes=abc"sv, SIZE).status == Status::NONE);
+            CHECK(ParseRange("bytes=20-10"sv, SIZE).status == Status::NONE);
+            CHECK(ParseRange("bytes=0-10,20-30"sv, SIZE).status == Status::NONE);
+        }
+    }
+}
+
+SCENARIO("Accept-Encoding header") {
+    using http_handler::AcceptsGzip;
+
+    GIVEN("typical browser headers") {
+        THEN("gzip is accepted") {
+            CHECK(AcceptsGzip("gzip, deflate, br"sv));
+            CHECK(AcceptsGzip("br;q=1.0, GZIP;q=0.8"sv));
+            CHECK(AcceptsGzip("*"sv));
+        }
+    }
+
+    GIVEN("headers without gzip or with gzip forbidden") {
+        THEN("gzip is not accepted") {
+            CHECK(!AcceptsGzip(""sv));
+            CHECK(!AcceptsGzip("identity"sv));
+            CHECK(!AcceptsGzip("deflate, br"sv));
+            CHECK(!AcceptsGzip("gzip;q=0"sv));
+            CHECK(!AcceptsGzip("gzip; q=0.000, *"sv));
+            CHECK(!AcceptsGzip("*;q=0"sv));
+        }
+    }
+}
+
+SCENARIO("HTTP date") {
+    using namespace std::chrono;
+
+    GIVEN("a file time") {
+        const auto time = file_clock::from_sys(sys_days{1994y / November / 6} + 8h + 49min + 37s + 250ms);
+
+        THEN("it is formatted as IMF-fixdate with whole seconds") {
+            CHECK(http_handler::FormatHttpDate(time) == "Sun, 06 Nov 1994 08:49:37 GMT");
+            CHECK(http_handler::ToSysSeconds(time) == sys_days{1994y / November / 6} + 8h + 49min + 37s);
+        }
+
+        THEN("the formatted date is parsed back") {
+            const auto parsed = http_handler::ParseHttpDate(http_handler::FormatHttpDate(time));
+            REQUIRE(parsed);
+            CHECK(*parsed == http_handler::ToSysSeconds(time));
+        }
+    }
+
+    GIVEN("malformed and obsolete dates") {
+        THEN("they are not parsed") {
+            CHECK(!http_handler::ParseHttpDate(""sv));
+            CHECK(!http_handler::ParseHttpDate("Sunday, 06-Nov-94 08:49:37 GMT"sv));
+            CHECK(!http_handler::ParseHttpDate("Sun Nov  6 08:49:37 1994"sv));
+            CHECK(!http_handler::ParseHttpDate("Sun, 31 Feb 1994 08:49:37 GMT"sv));
+            CHECK(!http_handler::ParseHttpDate("Sun, 06 Now 1994 08:49:37 GMT"sv));
+        }
+    }
+}
+
+SCENARIO("Entity tags") {
+    using namespace http_handler;
+
+    GIVEN("tags of two contents") {
+        const auto etag = MakeETag("let a = 1;"sv);
+        const auto other = MakeETag("let a = 2;"sv);
+
+        THEN("tags are quoted, stable and depend on the content") {
+            CHECK(etag.front() == '"');
+            CHECK(etag.back() == '"');
+            CHECK(etag == MakeETag("let a = 1;"sv));
+            CHECK(etag != other);
+            CHECK(MakeGzipETag(etag) != etag);
+            CHECK(MakeGzipETag(etag).back() == '"');
+        }
+
+        THEN("If-None-Match lists are matched") {
+            CHECK(MatchesETag(etag, etag));
+            CHECK(MatchesETag(other + ", " + etag, etag));
+            CHECK(MatchesETag("W/" + etag, etag));
+            CHECK(MatchesETag("*"sv, etag));
+            CHECK(!MatchesETag(other, etag));
+            CHECK(!MatchesETag(""sv, etag));
+            CHECK(!MatchesETag("*"sv, ""sv));
+        }
+    }
+}
+
+SCENARIO("Query parameters") {
+    using http_handler::FindQueryParameter;
+
+    GIVEN("a target with several parameters") {
+        constexpr auto target = "/api/v1/game/state?since=12&radius=2.5&flag&token="sv;
+
+        THEN("values are found by name") {
+            CHECK(FindQueryParameter(target, "since"sv) == "12"sv);
+            CHECK(FindQueryParameter(target, "radius"sv) == "2.5"sv);
+            CHECK(FindQueryParameter(target, "flag"sv) == ""sv);
+            CHECK(FindQueryParameter(target, "token"sv) == ""sv);
+        }
+
+        THEN("missing names and the path are not matched") {
+            CHECK(!FindQueryParameter(target, "radiu"sv));
+            CHECK(!FindQueryParameter(target, "state"sv));
+            CHECK(!FindQueryParameter("/api/v1/game/state"sv, "since"sv));
+            CHECK(!FindQueryParameter("/index.html?"sv, "v"sv));
+        }
+    }
+}
+
+SCENARIO("Request target redaction") {
+    using http_handler::RedactQueryParameter;
+
+    GIVEN("targets with and without a token") {
+
+        THEN("only the token value is hidden") {
+            CHECK(RedactQueryParameter("/api/v1/game/state?token=0123456789abcdef"sv, "token"sv) == "/api/v1/game/state?token=***");
+            CHECK(RedactQueryParameter("/api/v1/game/state?since=3&token=abc&radius=2"sv, "token"sv)
+                  == "/api/v1/game/state?since=3&token=***&radius=2");
+            CHECK(RedactQueryParameter("/api/v1/game/state?token"sv, "token"sv) == "/api/v1/game/state?token=***");
+        }
+
+        THEN("other targets are unchanged") {
+            CHECK(RedactQueryParameter("/api/v1/game/state"sv, "token"sv) == "/api/v1/game/state");
+            CHECK(RedactQueryParameter("/index.html?v=2&tokens=1"sv, "token"sv) == "/index.html?v=2&tokens=1");
+        }
+    }
+}
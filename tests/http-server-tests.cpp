@@ -0,0 +1,157 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/http_server/http_server.h"
+#include "../src/request_handler/http_headers.h"
+#include "temp-dir.h"
+
+#include <filesystem>
+#include <functional>
+#include <random>
+#include <thread>
+
+using namespace std::literals;
+
+namespace {
+
+namespace net = http_server::net;
+namespace http = http_server::http;
+using tcp = http_server::tcp;
+
+// Отдаёт файл path через SendfileBody, учитывая заголовок Range
+struct FileHandler {
+    std::filesystem::path path;
+
+    template <typename Send>
+    void operator()(http::request<http::string_body>&& req, Send&& send, [[maybe_unused]] const std::string& ip) {
+        http_server::SendfileBody::value_type file;
+        http_server::beast::error_code ec;
+        file.file.open(path.string().c_str(), http_server::beast::file_mode::read, ec);
+        const auto size = file.file.size(ec);
+
+        const auto range_header = req[http::field::range];
+        const auto range = http_handler::ParseRange({range_header.data(), range_header.size()}, size);
+        const bool partial = range.status == http_handler::RangeRequest::Status::SATISFIABLE;
+
+        file.offset = partial ? range.range.offset : 0;
+        file.length = partial ? range.range.length : size;
+
+        http::response<http_server::SendfileBody> response(partial ? http::status::partial_content : http::status::ok,
+                                                            req.version());
+        response.body() = std::move(file);
+        response.keep_alive(req.keep_alive());
+        response.prepare_payload();
+        send(std::move(response));
+    }
+
+    template <typename Send, typename Accept>
+    void Upgrade([[maybe_unused]] http::request<http::string_body>&& req, [[maybe_unused]] Send&& send,
+                 [[maybe_unused]] Accept&& accept, [[maybe_unused]] const std::string& ip) {
+    }
+};
+
+}  // namespace
+
+SCENARIO("Sending files with sendfile") {
+
+    GIVEN("a server that sends a file") {
+        std::string content;
+        std::mt19937 generator{3};
+        for (int i = 0; i < (1 << 22); ++i) {
+            content += static_cast<char>('a' + generator() % 26);
+        }
+
+        const test_utils::TempDir dir{"sendfile"};
+        const auto path = dir.Write("file", content);
+
+        constexpr auto WRITE_TIMEOUT = 200ms;
+        // Небольшие буферы сокетов, чтобы файл не поместился в них целиком
+        constexpr int SOCKET_BUFFER_SIZE = 16 * 1024;
+
+        net::io_context ioc;
+        tcp::acceptor acceptor{ioc, {net::ip::make_address("127.0.0.1"), 0}};
+
+        // Клиент работает в своём io_context, чтобы читать асинхронно с ограничением по времени
+        net::io_context client_ioc;
+        tcp::socket client{client_ioc};
+        client.open(tcp::v4());
+        client.set_option(net::socket_base::receive_buffer_size(SOCKET_BUFFER_SIZE));
+        client.connect(acceptor.local_endpoint());
+
+        tcp::socket server_socket = acceptor.accept(net::make_strand(ioc));
+        server_socket.set_option(net::socket_base::send_buffer_size(SOCKET_BUFFER_SIZE));
+
+        // Сессия работает в своём strand, как после Listener
+        auto session = std::make_shared<http_server::Session<FileHandler>>(std::move(server_socket), FileHandler{path}, "127.0.0.1"s);
+        session->SetWriteTimeout(WRITE_TIMEOUT);
+        session->Run();
+        std::thread server{[&ioc] { ioc.run(); }};
+
+        auto send_request = [&client](std::string_view range) {
+            http::request<http::string_body> req{http::verb::get, "/file", 11};
+            req.keep_alive(true);
+            if (!range.empty()) {
+                req.set(http::field::range, range);
+            }
+            http::write(client, req);
+        };
+
+        auto request = [&client, &send_request](std::string_view range) {
+            send_request(range);
+
+            http_server::beast::flat_buffer buffer;
+            http::response<http::string_body> res;
+            http::read(client, buffer, res);
+            return res;
+        };
+
+        WHEN("a byte range is requested") {
+            const auto res = request("bytes=70000-70999"sv);
+
+            THEN("only the range is sent and the connection serves the next request") {
+                CHECK(res.result() == http::status::partial_content);
+                CHECK(res.body() == content.substr(70000, 1000));
+
+                const auto full = request(""sv);
+                CHECK(full.result() == http::status::ok);
+                CHECK(full.body() == content);
+            }
+        }
+
+#ifdef __linux__
+        WHEN("the client stops reading the file") {
+            send_request(""sv);
+            std::this_thread::sleep_for(WRITE_TIMEOUT * 5);
+
+            THEN("the server closes the connection before the file is sent") {
+                std::string chunk(1 << 16, '\0');
+                std::size_t received = 0;
+                http_server::beast::error_code read_ec;
+
+                std::function<void()> read_more = [&] {
+                    client.async_read_some(net::buffer(chunk), [&](http_server::beast::error_code ec, std::size_t bytes_read) {
+                        received += bytes_read;
+                        if (ec) {
+                            read_ec = ec;
+                            return;
+                        }
+                        read_more();
+                    });
+                };
+                read_more();
+                client_ioc.run_for(5s);
+
+                CHECK(read_ec);
+                CHECK(received < content.size());
+            }
+        }
+#endif
+
+        // Сессия завершается, когда клиент закрывает соединение
+        http_server::beast::error_code ec;
+        client.shutdown(tcp::socket::shutdown_send, ec);
+        client.close(ec);
+        client_ioc.restart();
+        client_ioc.run();
+        server.join();
+    }
+}
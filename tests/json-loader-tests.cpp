@@ -0,0 +1,57 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/json_loader.h"
+#include "temp-dir.h"
+
+using namespace std::literals;
+
+SCENARIO("Loading the player cap per session") {
+
+    GIVEN("a positive cap") {
+        test_utils::TempDir dir;
+        const auto config = dir.Write("config.json", R"({"maxPlayersPerSession": 3, "maps": []})");
+
+        THEN("it is loaded") {
+            CHECK(json_loader::LoadGame(config).GetMaxPlayersPerSession() == 3u);
+        }
+    }
+
+    GIVEN("a zero cap") {
+        test_utils::TempDir dir;
+        const auto config = dir.Write("config.json", R"({"maxPlayersPerSession": 0, "maps": []})");
+
+        THEN("the config is rejected") {
+            CHECK_THROWS_AS(json_loader::LoadGame(config), std::invalid_argument);
+        }
+    }
+
+    GIVEN("a negative cap") {
+        test_utils::TempDir dir;
+        const auto config = dir.Write("config.json", R"({"maxPlayersPerSession": -1, "maps": []})");
+
+        THEN("the config is rejected") {
+            CHECK_THROWS_AS(json_loader::LoadGame(config), std::invalid_argument);
+        }
+    }
+}
+
+SCENARIO("Loading the random seed") {
+
+    GIVEN("a seed above INT64_MAX") {
+        test_utils::TempDir dir;
+        const auto config = dir.Write("config.json", R"({"randomSeed": 18446744073709551615, "maps": []})");
+
+        THEN("the full 64-bit value is loaded") {
+            CHECK(json_loader::LoadGame(config).GetRandomSeed() == 18446744073709551615ull);
+        }
+    }
+
+    GIVEN("a small seed") {
+        test_utils::TempDir dir;
+        const auto config = dir.Write("config.json", R"({"randomSeed": 42, "maps": []})");
+
+        THEN("it is loaded") {
+            CHECK(json_loader::LoadGame(config).GetRandomSeed() == 42u);
+        }
+    }
+}
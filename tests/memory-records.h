@@ -0,0 +1,29 @@
+#pragma once
+
+#include "../src/database/records_repository.h"
+
+#include <vector>
+
+namespace test_utils {
+
+// Рекорды в памяти вместо базы данных, в порядке добавления
+class MemoryRecords : public postgres::IRecordsRepository {
+public:
+    void AddRecords(const std::vector<postgres::PlayerInfo>& infos) override {
+        records_.insert(records_.end(), infos.begin(), infos.end());
+    }
+
+    std::vector<postgres::PlayerInfo> GetRecords([[maybe_unused]] std::optional<int> start,
+                                                 [[maybe_unused]] std::optional<int> maxItems) override {
+        return records_;
+    }
+
+    const std::vector<postgres::PlayerInfo>& GetAll() const {
+        return records_;
+    }
+
+private:
+    std::vector<postgres::PlayerInfo> records_;
+};
+
+}  // namespace test_utils
@@ -1,7 +1,11 @@
+#include <algorithm>
 #include <cmath>
+#include <limits>
+#include <random>
 #include <catch2/catch_test_macros.hpp>
 
 #include "../src/model/model.h"
+#include "../src/model/point_grid.h"
 
 using namespace std::literals;
 
@@ -50,4 +54,347 @@ SCENARIO("Model tests") {
             }
         }
     }
-}    
\ No newline at end of file
+}    
+SCENARIO("Road index") {
+
+    GIVEN("a set of crossing and overlapping roads") {
+        std::vector<model::Road> roads {
+            model::Road{model::Road::HORIZONTAL, {0, 0}, 10},
+            model::Road{model::Road::HORIZONTAL, {10, 0}, 20},
+            model::Road{model::Road::HORIZONTAL, {15, 0}, 5},
+            model::Road{model::Road::HORIZONTAL, {0, 5}, 30},
+            model::Road{model::Road::VERTICAL, {0, 0}, 5},
+            model::Road{model::Road::VERTICAL, {10, 10}, 0},
+            model::Road{model::Road::VERTICAL, {10, 0}, 3},
+            model::Road{model::Road::VERTICAL, {30, 5}, 20},
+        };
+
+        model::RoadIndex index{roads};
+
+        THEN("it finds the same roads as a linear scan") {
+            for (double x = -1.; x <= 31.; x += 0.1) {
+                for (double y = -1.; y <= 21.; y += 0.1) {
+                    model::Point point{x, y};
+
+                    std::vector<size_t> expected;
+                    for (size_t i = 0; i < roads.size(); ++i) {
+                        if (roads[i].IsOnTheRoad(point)) {
+                            expected.push_back(i);
+                        }
+                    }
+
+                    std::vector<size_t> found;
+                    index.ForEachRoadAt(point, [&found](size_t i, const model::Road&) {
+                        found.push_back(i);
+                    });
+                    std::sort(found.begin(), found.end());
+
+                    INFO("x: " << x << ", y: " << y);
+                    REQUIRE(found == expected);
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Road merging") {
+
+    GIVEN("a chain of collinear adjacent roads") {
+        std::vector<model::Road> roads {
+            model::Road{model::Road::HORIZONTAL, {20, 0}, 10},
+            model::Road{model::Road::HORIZONTAL, {0, 0}, 10},
+            model::Road{model::Road::HORIZONTAL, {20, 0}, 30},
+            model::Road{model::Road::HORIZONTAL, {40, 0}, 50},
+            model::Road{model::Road::VERTICAL, {0, 0}, 5},
+            model::Road{model::Road::VERTICAL, {0, 3}, 8},
+        };
+
+        WHEN("roads are loaded") {
+            auto merged = model::RoadLoader{roads}.GetDicts();
+
+            THEN("touching and overlapping runs become maximal segments") {
+                REQUIRE(merged.size() == 3);
+
+                CHECK(std::count(merged.begin(), merged.end(),
+                                 model::Road{model::Road::HORIZONTAL, {0, 0}, 30}) == 1);
+                CHECK(std::count(merged.begin(), merged.end(),
+                                 model::Road{model::Road::HORIZONTAL, {40, 0}, 50}) == 1);
+                CHECK(std::count(merged.begin(), merged.end(),
+                                 model::Road{model::Road::VERTICAL, {0, 0}, 8}) == 1);
+            }
+        }
+    }
+}
+
+SCENARIO("Dogs stored in a game session") {
+
+    GIVEN("a session with a dog") {
+        model::Map simple_map(model::Map::Id("test_map"), "TestMap");
+        simple_map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 10});
+
+        model::GameSession session {simple_map, model::LootGeneratorConfig{5, 0}, 1000.0};
+
+        auto dog = std::make_shared<model::Dog>("test_dog");
+        dog->SetDefaultSpeed(1.f);
+        session.AddDog(dog, false);
+
+        WHEN("the dog moves") {
+            dog->Move(model::Direction::EAST);
+            session.UpdateGameState(500);
+
+            THEN("the dog sees its updated position") {
+                CHECK(dog->GetPosition() == model::Point{0.5, 0});
+                CHECK(dog->GetUptime() == 500.0);
+            }
+        }
+
+        WHEN("the dog retires") {
+            dog->AccumulateScore(7);
+            auto ids = session.UpdateGameState(1000);
+
+            THEN("it is removed from the session and keeps its data") {
+                REQUIRE(ids.size() == 1);
+                CHECK(session.GetDogs().empty());
+                CHECK(dog->GetScore() == 7);
+                CHECK(dog->GetName() == "test_dog");
+                CHECK(session.GetDog(*dog->GetDogId()) == nullptr);
+            }
+        }
+
+        WHEN("an earlier dog retires while a later one keeps moving") {
+            auto other = std::make_shared<model::Dog>("other_dog");
+            other->SetDefaultSpeed(1.f);
+            auto other_id = session.AddDog(other, false);
+            other->Move(model::Direction::EAST);
+
+            session.UpdateGameState(1000);
+
+            THEN("the remaining dog is still found by id") {
+                CHECK(session.GetDog(*dog->GetDogId()) == nullptr);
+                CHECK(session.GetDog(other_id) == other);
+            }
+        }
+    }
+}
+
+SCENARIO("Seeded game sessions") {
+
+    GIVEN("two sessions with the same seed") {
+        model::Map simple_map(model::Map::Id("test_map"), "TestMap");
+        simple_map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 10});
+        simple_map.AddRoad(model::Road{model::Road::VERTICAL, {0, 0}, 10});
+
+        model::GameSession session1 {simple_map, model::LootGeneratorConfig{5, 1}, 1000.0, 42};
+        model::GameSession session2 {simple_map, model::LootGeneratorConfig{5, 1}, 1000.0, 42};
+
+        WHEN("dogs spawn at random positions") {
+            THEN("positions are the same in both sessions") {
+                for (int i = 0; i < 10; ++i) {
+                    auto dog1 = std::make_shared<model::Dog>("dog");
+                    auto dog2 = std::make_shared<model::Dog>("dog");
+                    session1.AddDog(dog1, true);
+                    session2.AddDog(dog2, true);
+
+                    REQUIRE(dog1->GetPosition() == dog2->GetPosition());
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Loot storage") {
+
+    GIVEN("a storage with a few loot items") {
+
+        model::LootStorage storage;
+        for (size_t i = 0; i < 5; ++i) {
+            storage.Add(i % 2, {static_cast<double>(i), 0.}, i * 10);
+        }
+
+        WHEN("items are removed") {
+            REQUIRE(storage.Remove(1));
+            REQUIRE(storage.Remove(4));
+            REQUIRE_FALSE(storage.Remove(1));
+
+            THEN("the rest is found by id and new ids are not reused") {
+                REQUIRE(storage.Size() == 3);
+                REQUIRE(storage.Find(1) == nullptr);
+                for (int id : {0, 2, 3}) {
+                    const auto* loot = storage.Find(id);
+                    REQUIRE(loot != nullptr);
+                    CHECK(loot->position.x == static_cast<double>(id));
+                }
+
+                CHECK(storage.Add(0, {}, 0).id == 5);
+            }
+        }
+
+        WHEN("items are restored") {
+            storage.Reset({model::LootState{7, 0, {1., 1.}}}, 10);
+
+            THEN("next id does not collide with restored ones") {
+                REQUIRE(storage.Find(7) != nullptr);
+                CHECK(storage.Add(0, {}, 0).id == 10);
+            }
+        }
+    }
+}
+
+SCENARIO("Change tracking") {
+
+    GIVEN("a session with a moving and an idle dog") {
+        model::Map simple_map(model::Map::Id("test_map"), "TestMap");
+        simple_map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 10});
+
+        model::GameSession session {simple_map, model::LootGeneratorConfig{5, 0}, 1000.0};
+
+        auto moving = std::make_shared<model::Dog>("moving");
+        moving->SetDefaultSpeed(1.f);
+        session.AddDog(moving, false);
+
+        auto idle = std::make_shared<model::Dog>("idle");
+        session.AddDog(idle, false);
+
+        session.UpdateGameState(100);
+        REQUIRE(session.GetTick() == 1);
+
+        WHEN("only one dog moves") {
+            moving->Move(model::Direction::EAST);
+            session.UpdateGameState(100);
+
+            THEN("only that dog is marked as changed on the new tick") {
+                CHECK(session.GetTick() == 2);
+                CHECK(moving->GetChangedTick() == 2);
+                CHECK(idle->GetChangedTick() == 1);
+            }
+        }
+
+        WHEN("both dogs stand still until retirement") {
+            session.UpdateGameState(1000);
+
+            THEN("their removal is recorded for the tick") {
+                REQUIRE(session.GetRemovals().size() == 1);
+                const auto& removals = session.GetRemovals().front();
+                CHECK(removals.tick == 2);
+                CHECK(removals.dog_ids.size() == 2);
+            }
+        }
+
+        WHEN("the tick is restored") {
+            session.SetTick(500);
+
+            THEN("the restored tick and older ones can not be used for changes") {
+                CHECK(session.GetHistoryStartTick() == 501);
+                CHECK(session.GetRemovals().empty());
+
+                session.UpdateGameState(100);
+                CHECK(session.GetTick() == 501);
+                CHECK(session.GetHistoryStartTick() == 501);
+            }
+        }
+    }
+}
+
+SCENARIO("Point grid") {
+
+    GIVEN("random points") {
+        std::mt19937 generator{7};
+        std::uniform_real_distribution<double> coordinate{-50., 150.};
+
+        std::vector<geom::Point2D> points;
+        for (int i = 0; i < 500; ++i) {
+            points.emplace_back(coordinate(generator), coordinate(generator));
+        }
+        model::PointGrid grid{points};
+
+        THEN("points within a radius are the same as found by a linear scan") {
+            for (auto radius : {0., 3., 17.5, 400.}) {
+                for (const auto& center : {geom::Point2D{0., 0.}, geom::Point2D{120., -40.}, geom::Point2D{-300., 20.}}) {
+                    std::vector<size_t> expected;
+                    for (size_t i = 0; i < points.size(); ++i) {
+                        const double dx = points[i].x - center.x;
+                        const double dy = points[i].y - center.y;
+                        if (dx * dx + dy * dy <= radius * radius) {
+                            expected.push_back(i);
+                        }
+                    }
+
+                    std::vector<size_t> found;
+                    grid.ForEachInRadius(center, radius, [&found](size_t index) {
+                        found.push_back(index);
+                    });
+                    std::sort(found.begin(), found.end());
+
+                    CHECK(found == expected);
+                }
+            }
+        }
+
+        THEN("a huge radius covers every point") {
+            for (auto radius : {1e300, std::numeric_limits<double>::max()}) {
+                size_t found = 0;
+                grid.ForEachInRadius({0., 0.}, radius, [&found](size_t) {
+                    ++found;
+                });
+                CHECK(found == points.size());
+            }
+        }
+    }
+}
+
+SCENARIO("Game sessions of one map") {
+
+    GIVEN("a game with a player cap per session") {
+        model::Game game;
+        model::Map simple_map(model::Map::Id("test_map"), "TestMap");
+        simple_map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 10});
+        game.AddMap(simple_map);
+        game.SetMaxPlayersPerSession(2);
+
+        const model::Map::Id map_id{"test_map"};
+
+        WHEN("more players join than fit into one session") {
+            std::vector<model::GameSession*> placed;
+            for (int i = 0; i < 5; ++i) {
+                auto* session = game.GetSessionForJoin(map_id);
+                session->AddDog(std::make_shared<model::Dog>("dog"), false);
+                placed.push_back(session);
+            }
+
+            THEN("new sessions are created and none exceeds the cap") {
+                REQUIRE(game.GetMapSessions(map_id).size() == 3);
+                for (const auto& session_id : game.GetMapSessions(map_id)) {
+                    CHECK(game.FindSession(session_id)->GetDogsCount() <= 2);
+                }
+                // В последней сессии ещё есть место
+                CHECK(game.GetSessionForJoin(map_id) == placed.back());
+            }
+
+            AND_WHEN("a session becomes empty") {
+                placed.back()->UpdateGameState(static_cast<std::int64_t>(game.GetDogRetirementTime()));
+                auto removed = game.RemoveEmptySessions();
+
+                THEN("it is torn down and a full map gets a new session on the next join") {
+                    REQUIRE(removed.size() == 1);
+                    CHECK(game.GetMapSessions(map_id).size() == 2);
+                    CHECK(game.GetSessionForJoin(map_id)->GetDogsCount() == 0);
+                    CHECK(game.GetMapSessions(map_id).size() == 3);
+                }
+            }
+        }
+    }
+
+    GIVEN("a game without a player cap") {
+        model::Game game;
+        model::Map simple_map(model::Map::Id("test_map"), "TestMap");
+        simple_map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 10});
+        game.AddMap(simple_map);
+
+        THEN("all players share one session") {
+            auto* first = game.GetSessionForJoin(model::Map::Id{"test_map"});
+            first->AddDog(std::make_shared<model::Dog>("dog"), false);
+            CHECK(game.GetSessionForJoin(model::Map::Id{"test_map"}) == first);
+            CHECK(game.RemoveEmptySessions().empty());
+        }
+    }
+}
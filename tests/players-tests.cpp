@@ -0,0 +1,144 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/application/player.h"
+#include "../src/application/token_map.h"
+
+SCENARIO("Players registry") {
+
+    GIVEN("players on two maps with the same dog ids") {
+
+        model::Map map1(model::Map::Id("map1"), "Map 1");
+        map1.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 10});
+        model::Map map2(model::Map::Id("map2"), "Map 2");
+        map2.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 10});
+
+        model::GameSession session1{map1, model::LootGeneratorConfig{5, 1}, 15.0, std::nullopt, model::GameSession::Id{1}};
+        model::GameSession session2{map2, model::LootGeneratorConfig{5, 1}, 15.0, std::nullopt, model::GameSession::Id{2}};
+
+        application::Players players;
+        std::vector<std::pair<application::Player*, application::Token>> added;
+
+        for (int i = 0; i < 3; ++i) {
+            for (auto* session : {&session1, &session2}) {
+                auto dog = std::make_shared<model::Dog>("dog");
+                session->AddDog(dog, false);
+                added.push_back(players.AddPlayer(dog, session));
+            }
+        }
+
+        THEN("players are found by token and by map and dog id") {
+            REQUIRE(players.Size() == 6);
+            const auto& const_players = players;
+            for (const auto& [player, token] : added) {
+                CHECK(players.FindByToken(token) == player);
+                CHECK(players.FindByDogIdAndSessionId(player->GetDog()->GetDogId(), player->GetSession()->GetId()) == player);
+                CHECK(const_players.FindByToken(token) == player);
+                CHECK(const_players.FindByDogIdAndSessionId(player->GetDog()->GetDogId(), player->GetSession()->GetId()) == player);
+            }
+        }
+
+        WHEN("a player is removed") {
+            auto [removed, removed_token] = added[2];
+            auto* other = added[3].first;
+
+            REQUIRE(players.RemovePlayer(removed->GetDog()->GetDogId(), session1.GetId()));
+
+            THEN("only that player is gone and other handles stay valid") {
+                CHECK(players.Size() == 5);
+                CHECK_FALSE(players.IsTokenValid(removed_token));
+                CHECK(players.FindByDogIdAndSessionId(model::Dog::Id{1}, session1.GetId()) == nullptr);
+                CHECK(players.FindByDogIdAndSessionId(model::Dog::Id{1}, session2.GetId()) == other);
+                CHECK(players.FindByToken(added[3].second) == other);
+
+                const auto& const_players = players;
+                CHECK(const_players.FindByToken(removed_token) == nullptr);
+                CHECK(const_players.FindByDogIdAndSessionId(model::Dog::Id{1}, session1.GetId()) == nullptr);
+                CHECK_FALSE(const_players.FindToken(model::Dog::Id{1}, session1.GetId()));
+                CHECK(const_players.FindToken(model::Dog::Id{1}, session2.GetId()) == added[3].second);
+                CHECK_FALSE(players.RemovePlayer(model::Dog::Id{1}, session1.GetId()));
+            }
+
+            AND_WHEN("the registry is restored from its serialized form") {
+                std::vector<application::Player> copies;
+                for (const auto* player : players.GetPlayers()) {
+                    copies.push_back(*player);
+                }
+
+                application::Players restored;
+                restored.Restore(std::move(copies), players.GetPlayerIdToIndex());
+
+                THEN("tokens point to the same dogs") {
+                    REQUIRE(restored.Size() == 5);
+                    for (const auto& [player, token] : added) {
+                        if (token == removed_token) {
+                            continue;
+                        }
+                        REQUIRE(restored.FindByToken(token) != nullptr);
+                        CHECK(restored.FindByToken(token)->GetDog() == player->GetDog());
+                    }
+                }
+            }
+        }
+    }
+}
+
+SCENARIO("Player tokens") {
+
+    GIVEN("a token") {
+        const application::Token token{0x0123456789abcdefULL, 0xfedcba9876543210ULL};
+
+        THEN("it is encoded as 32 lowercase hex digits and parsed back") {
+            const auto hex = token.ToHex();
+            CHECK(hex == "0123456789abcdeffedcba9876543210");
+            CHECK(application::Token::FromHex(hex) == token);
+        }
+
+        THEN("malformed strings are rejected") {
+            CHECK_FALSE(application::Token::FromHex("0123456789abcdeffedcba987654321"));
+            CHECK_FALSE(application::Token::FromHex("0123456789abcdeffedcba98765432100"));
+            CHECK_FALSE(application::Token::FromHex("0123456789ABCDEFfedcba9876543210"));
+            CHECK_FALSE(application::Token::FromHex("0123456789abcdeffedcba987654321g"));
+        }
+    }
+}
+
+SCENARIO("Token map") {
+
+    GIVEN("a map with tokens in different shards") {
+        application::TokenMap<int> tokens;
+        std::vector<application::Token> added;
+        for (std::uint64_t i = 0; i < 32; ++i) {
+            added.emplace_back(i << 59, i);
+            tokens.Insert(added.back(), static_cast<int>(i));
+        }
+
+        THEN("every token is found") {
+            CHECK(tokens.Size() == added.size());
+            for (size_t i = 0; i < added.size(); ++i) {
+                REQUIRE(tokens.Find(added[i]));
+                CHECK(*tokens.Find(added[i]) == static_cast<int>(i));
+            }
+        }
+
+        WHEN("one token is erased") {
+            CHECK(tokens.Erase(added[5]));
+
+            THEN("only it disappears") {
+                CHECK_FALSE(tokens.Contains(added[5]));
+                CHECK_FALSE(tokens.Find(added[5]));
+                CHECK_FALSE(tokens.Erase(added[5]));
+                CHECK(tokens.Contains(added[4]));
+                CHECK(tokens.Size() == added.size() - 1);
+            }
+        }
+
+        WHEN("the map is cleared") {
+            tokens.Clear();
+
+            THEN("it is empty") {
+                CHECK(tokens.Size() == 0);
+                CHECK_FALSE(tokens.Contains(added[0]));
+            }
+        }
+    }
+}
@@ -72,3 +72,58 @@ SCENARIO_METHOD(Fixture, "Dog Serialization") {
         }
     }
 }
+
+SCENARIO_METHOD(Fixture, "Game session serialization") {
+    GIVEN("a session with dogs, loot and removal history") {
+        Map map(Map::Id("map1"), "Map 1");
+        map.AddRoad(Road{Road::HORIZONTAL, {0, 0}, 10});
+        map.AddLootType(LootType{"key", "assets/key.obj", "obj", 90, "#338844", 0.03});
+
+        GameSession session{map, LootGeneratorConfig{5, 1}, 1000.0, 7u, GameSession::Id{3}};
+        session.AddDog(std::make_shared<Dog>("stays"), false);
+        auto leaving = std::make_shared<Dog>("leaves");
+        leaving->SetDefaultSpeed(1.f);
+        session.AddDog(leaving, false);
+
+        leaving->Move(Direction::EAST);
+        session.UpdateGameState(100);
+        session.UpdateGameState(1000);
+        REQUIRE(session.GetTick() == 2);
+        REQUIRE_FALSE(session.GetRemovals().empty());
+        REQUIRE_FALSE(session.GetLootStates().empty());
+
+        WHEN("the session is serialized and restored") {
+            {
+                serialization::GameSessionRepr repr{session};
+                output_archive << repr;
+            }
+
+            InputArchive input_archive{strm};
+            serialization::GameSessionRepr repr;
+            input_archive >> repr;
+            auto restored = repr.Restore(&map, LootGeneratorConfig{5, 1});
+
+            THEN("the state is kept") {
+                CHECK(restored.GetId() == session.GetId());
+                CHECK(restored.GetTick() == session.GetTick());
+                CHECK(restored.GetDogsCount() == session.GetDogsCount());
+                CHECK(restored.GetLootStates().size() == session.GetLootStates().size());
+            }
+
+            THEN("changes since the restored tick or earlier are not available, so clients get the full state") {
+                // Тики появления трофеев и история удалений не сохраняются
+                CHECK(restored.GetRemovals().empty());
+                CHECK(restored.GetHistoryStartTick() > restored.GetTick());
+
+                AND_WHEN("the restored session is updated") {
+                    restored.UpdateGameState(100);
+
+                    THEN("only changes after the restored tick are available") {
+                        CHECK(restored.GetTick() == session.GetTick() + 1);
+                        CHECK(restored.GetHistoryStartTick() == session.GetTick() + 1);
+                    }
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,213 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/request_handler/static_file_cache.h"
+#include "../src/request_handler/gzip.h"
+#include "../src/request_handler/http_headers.h"
+#include "temp-dir.h"
+
+#include <boost/beast/zlib/inflate_stream.hpp>
+#include <boost/crc.hpp>
+
+using namespace std::literals;
+
+namespace {
+
+using test_utils::TempDir;
+
+// Распаковывает gzip без флагов заголовка, проверяя длину и контрольную сумму
+std::string Gunzip(const std::string& gzip) {
+    namespace zlib = boost::beast::zlib;
+
+    constexpr size_t HEADER_SIZE = 10;
+    constexpr size_t TRAILER_SIZE = 8;
+    REQUIRE(gzip.size() >= HEADER_SIZE + TRAILER_SIZE);
+    REQUIRE(static_cast<unsigned char>(gzip[0]) == 0x1f);
+    REQUIRE(static_cast<unsigned char>(gzip[1]) == 0x8b);
+
+    auto read_le = [&gzip](size_t pos) {
+        std::uint32_t value = 0;
+        for (int i = 3; i >= 0; --i) {
+            value = (value << 8) | static_cast<unsigned char>(gzip[pos + i]);
+        }
+        return value;
+    };
+
+    const auto crc = read_le(gzip.size() - TRAILER_SIZE);
+    const auto size = read_le(gzip.size() - 4);
+
+    std::string out(size, '\0');
+    zlib::inflate_stream inflate;
+    zlib::z_params params;
+    params.next_in = gzip.data() + HEADER_SIZE;
+    params.avail_in = gzip.size() - HEADER_SIZE - TRAILER_SIZE;
+    params.next_out = out.data();
+    params.avail_out = out.size();
+
+    boost::beast::error_code ec;
+    inflate.write(params, zlib::Flush::finish, ec);
+    CHECK(ec == zlib::error::end_of_stream);
+    CHECK(params.total_out == size);
+
+    boost::crc_32_type checksum;
+    checksum.process_bytes(out.data(), out.size());
+    CHECK(checksum.checksum() == crc);
+
+    return out;
+}
+
+}  // namespace
+
+SCENARIO("Gzip compression") {
+    GIVEN("repetitive text") {
+        std::string text;
+        for (int i = 0; i < 1000; ++i) {
+            text += "function f" + std::to_string(i % 10) + "() { return 42; }\n";
+        }
+
+        WHEN("it is compressed") {
+            const auto gzip = http_handler::GzipCompress(text);
+
+            THEN("it becomes smaller and decompresses back") {
+                CHECK(gzip.size() < text.size() / 10);
+                CHECK(Gunzip(gzip) == text);
+            }
+        }
+
+        THEN("empty data is compressed too") {
+            CHECK(Gunzip(http_handler::GzipCompress("")).empty());
+        }
+    }
+}
+
+SCENARIO("Static file cache") {
+    using http_handler::StaticFileCache;
+
+    GIVEN("a cache with capacity for three small files") {
+        TempDir dir{"static-cache"};
+        StaticFileCache cache;
+        cache.SetCapacity(40);
+
+        const auto now = StaticFileCache::Clock::now();
+        const auto a = dir.Write("a.js", "aaaaaaaaaa");
+        const auto b = dir.Write("b.js", "bbbbbbbbbb");
+        const auto c = dir.Write("c.js", "cccccccccc");
+
+        THEN("a file is found only after it has been loaded") {
+            CHECK(!cache.Find("/a.js", now));
+
+            auto loaded = cache.Load("/a.js", a, "text/javascript"sv, now);
+            REQUIRE(loaded);
+            CHECK(*loaded->content == "aaaaaaaaaa");
+            CHECK(loaded->content_type == "text/javascript"sv);
+
+            auto found = cache.Find("/a.js", now);
+            CHECK(found == loaded);
+            CHECK(cache.GetSize() == 10);
+        }
+
+        WHEN("more files are loaded than fit into the cache") {
+            cache.Load("/a.js", a, "text/javascript"sv, now);
+            cache.Load("/b.js", b, "text/javascript"sv, now);
+            cache.Find("/a.js", now);
+            cache.Load("/c.js", c, "text/javascript"sv, now);
+            cache.SetCapacity(20);
+
+            THEN("the least recently used file is evicted") {
+                CHECK(cache.Find("/a.js", now));
+                CHECK(!cache.Find("/b.js", now));
+                CHECK(cache.Find("/c.js", now));
+                CHECK(cache.GetSize() == 20);
+            }
+        }
+
+        WHEN("a cached file changes on disk") {
+            cache.Load("/a.js", a, "text/javascript"sv, now);
+            dir.Write("a.js", "changed");
+            std::filesystem::last_write_time(a, std::filesystem::last_write_time(a) + 1h);
+
+            THEN("the change is noticed once the check interval has passed") {
+                CHECK(cache.Find("/a.js", now));
+                CHECK(!cache.Find("/a.js", now + StaticFileCache::CHECK_INTERVAL));
+                CHECK(cache.GetSize() == 0);
+
+                auto reloaded = cache.Load("/a.js", a, "text/javascript"sv, now);
+                REQUIRE(reloaded);
+                CHECK(*reloaded->content == "changed");
+            }
+        }
+
+        THEN("files larger than a quarter of the capacity and missing files are not cached") {
+            const auto big = dir.Write("big.js", std::string(11, 'x'));
+            CHECK(!cache.Load("/big.js", big, "text/javascript"sv, now));
+            CHECK(!cache.Load("/missing.js", dir.Path("missing.js"), "text/javascript"sv, now));
+            CHECK(cache.GetSize() == 0);
+        }
+    }
+
+    GIVEN("a cache with room for text files") {
+        TempDir dir{"static-cache"};
+        StaticFileCache cache;
+        cache.SetCapacity(1 << 20);
+
+        const std::string script(4096, 'a');
+        const auto path = dir.Write("three.js", script);
+
+        WHEN("a text file is loaded") {
+            auto file = cache.Load("/three.js", path, "text/javascript"sv);
+
+            THEN("its gzip variant is built and counted in the cache size") {
+                REQUIRE(file);
+                REQUIRE(file->gzip_content);
+                CHECK(Gunzip(*file->gzip_content) == script);
+                CHECK(cache.GetSize() == script.size() + file->gzip_content->size());
+            }
+
+            THEN("both variants have their own entity tags") {
+                REQUIRE(file);
+                CHECK(file->gzip_etag == http_handler::MakeGzipETag(file->etag));
+                CHECK(file->gzip_etag != file->etag);
+            }
+
+            THEN("the tags match those of the file served without the cache") {
+                REQUIRE(file);
+                // Так ETag вычисляет RequestHandler для файла, которого нет в кэше
+                const auto uncached_etag = http_handler::MakeFileETag(std::filesystem::file_size(path),
+                                                                      std::filesystem::last_write_time(path));
+                CHECK(file->etag == uncached_etag);
+                CHECK(file->gzip_etag == http_handler::MakeGzipETag(uncached_etag));
+            }
+        }
+
+        WHEN("a prebuilt .gz file lies next to it") {
+            const auto sibling = dir.Write("three.js.gz", http_handler::GzipCompress("prebuilt"));
+
+            auto file = cache.Load("/three.js", path, "text/javascript"sv);
+
+            THEN("the prebuilt file is used") {
+                REQUIRE(file);
+                REQUIRE(file->gzip_content);
+                CHECK(Gunzip(*file->gzip_content) == "prebuilt");
+                CHECK(http_handler::FindGzipSibling(path, file->last_write_time) == sibling);
+            }
+        }
+
+        THEN("binary and small files have no gzip variant") {
+            auto binary = cache.Load("/pug.fbx", dir.Write("pug.fbx", script), "application/octet-stream"sv);
+            REQUIRE(binary);
+            CHECK(!binary->gzip_content);
+
+            auto small = cache.Load("/small.js", dir.Write("small.js", "let a = 1;"), "text/javascript"sv);
+            REQUIRE(small);
+            CHECK(!small->gzip_content);
+        }
+    }
+
+    GIVEN("a disabled cache") {
+        TempDir dir{"static-cache"};
+        StaticFileCache cache;
+
+        THEN("nothing is cached") {
+            CHECK(!cache.Load("/a.js", dir.Write("a.js", "a"), "text/javascript"sv));
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+
+namespace test_utils {
+
+// Временный каталог для файлов теста, удаляется вместе с объектом
+class TempDir {
+public:
+    explicit TempDir(const std::string& prefix = "game-server-test")
+        : path_(std::filesystem::temp_directory_path() / (prefix + "-" + std::to_string(std::random_device{}()))) {
+        std::filesystem::create_directories(path_);
+    }
+
+    TempDir(const TempDir&) = delete;
+    TempDir& operator=(const TempDir&) = delete;
+
+    ~TempDir() {
+        // Деструктор не бросает исключений, ошибка удаления игнорируется
+        std::error_code ec;
+        std::filesystem::remove_all(path_, ec);
+    }
+
+    std::filesystem::path Path(const std::string& name) const {
+        return path_ / name;
+    }
+
+    std::filesystem::path Write(const std::string& name, const std::string& content) const {
+        auto file_path = Path(name);
+        std::ofstream(file_path, std::ios::binary) << content;
+        return file_path;
+    }
+
+private:
+    std::filesystem::path path_;
+};
+
+}  // namespace test_utils
@@ -0,0 +1,102 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/ticker.h"
+
+#include <vector>
+
+using namespace std::literals;
+
+namespace {
+
+// Часы, которые идут только по команде теста
+struct ManualClock {
+    using duration = std::chrono::steady_clock::duration;
+    using rep = duration::rep;
+    using period = duration::period;
+    using time_point = std::chrono::time_point<ManualClock>;
+    static constexpr bool is_steady = true;
+
+    static time_point now() noexcept {
+        return current;
+    }
+
+    static void Advance(duration delta) {
+        current += delta;
+    }
+
+    static inline time_point current{};
+};
+
+}  // namespace
+
+SCENARIO("Ticker") {
+
+    GIVEN("a ticker driven by a manual clock") {
+        constexpr auto PERIOD = 10ms;
+        // Реальное время, за которое таймер успевает сработать после сдвига часов.
+        // Пока часы стоят, обработчик не вызывается, сколько бы ни прошло реального времени
+        constexpr auto WAKE_UP_TIME = PERIOD * 5;
+
+        ManualClock::current = ManualClock::time_point{};
+
+        net::io_context ioc;
+        std::vector<std::chrono::milliseconds> deltas;
+        auto ticker = std::make_shared<BasicTicker<ManualClock>>(net::make_strand(ioc), PERIOD,
+                                                                 [&deltas](std::chrono::milliseconds delta) {
+                                                                     deltas.push_back(delta);
+                                                                 });
+
+        auto advance = [&](ManualClock::duration delta) {
+            deltas.clear();
+            ManualClock::Advance(delta);
+            ioc.run_for(WAKE_UP_TIME);
+        };
+
+        WHEN("it runs with a variable step") {
+            ticker->Start();
+            ioc.run_for(WAKE_UP_TIME);
+
+            THEN("the handler receives the time elapsed since the previous tick") {
+                CHECK(deltas.empty());
+
+                advance(37ms);
+                CHECK(deltas == std::vector{37ms});
+
+                advance(12ms);
+                CHECK(deltas == std::vector{12ms});
+            }
+        }
+
+        WHEN("it runs with a fixed step") {
+            ticker->SetFixedStep(4);
+            ticker->Start();
+            ioc.run_for(WAKE_UP_TIME);
+
+            THEN("elapsed time is split into whole steps and the remainder is carried over") {
+                advance(35ms);
+                CHECK(deltas == std::vector{PERIOD, PERIOD, PERIOD});
+
+                // 5ms остатка и 10ms нового времени дают один шаг
+                advance(10ms);
+                CHECK(deltas == std::vector{PERIOD});
+
+                // До следующего момента пробуждения обработчик не вызывается
+                advance(5ms);
+                CHECK(deltas.empty());
+                advance(5ms);
+                CHECK(deltas == std::vector{PERIOD});
+            }
+
+            THEN("steps above the catch-up limit are dropped") {
+                advance(75ms);
+                CHECK(deltas == std::vector{PERIOD, PERIOD, PERIOD, PERIOD});
+
+                // Отставание в 30ms отброшено, остаток 5ms сохранён
+                advance(10ms);
+                CHECK(deltas == std::vector{PERIOD});
+            }
+        }
+
+        ioc.stop();
+    }
+}
@@ -0,0 +1,149 @@
+#include <catch2/catch_test_macros.hpp>
+
+#include "../src/request_handler/api_request_handler.h"
+#include "../src/request_handler/state_broadcaster.h"
+#include "memory-records.h"
+
+#include <thread>
+
+using namespace std::literals;
+
+namespace {
+
+namespace net = http_server::net;
+namespace http = http_server::http;
+namespace websocket = http_server::websocket;
+using tcp = http_server::tcp;
+
+// Передаёт запросы на открытие WebSocket обработчику API, как RequestHandler
+struct UpgradeHandler {
+    std::shared_ptr<http_handler::APIRequestHandler> api;
+
+    template <typename Send>
+    void operator()([[maybe_unused]] http::request<http::string_body>&& req, [[maybe_unused]] Send&& send,
+                    [[maybe_unused]] const std::string& ip) {
+    }
+
+    template <typename Send, typename Accept>
+    void Upgrade(http::request<http::string_body>&& req, Send&& send, Accept&& accept, [[maybe_unused]] const std::string& ip) {
+        api->Upgrade(std::move(req), std::forward<Send>(send), std::forward<Accept>(accept));
+    }
+};
+
+}  // namespace
+
+SCENARIO("Pushing the game state over WebSocket") {
+
+    GIVEN("a player in a game and a server that accepts WebSocket subscriptions") {
+        model::Game game;
+        model::Map map(model::Map::Id("map1"), "Map 1");
+        map.AddRoad(model::Road{model::Road::HORIZONTAL, {0, 0}, 10});
+        game.AddMap(map);
+        game.SetLootGeneratorConfig({5, 0});
+        game.SetDogRetirementTime(1000.0);
+
+        test_utils::MemoryRecords records;
+        application::Application app{game, records, false};
+
+        net::io_context ioc;
+        auto api = std::make_shared<http_handler::APIRequestHandler>(app, net::make_strand(ioc));
+        auto broadcaster = std::make_shared<http_handler::StateBroadcaster>(app);
+        api->SetStateBroadcaster(broadcaster);
+        app.AddUpdateListener(broadcaster);
+
+        const std::string token_hex = app.JoinToGame("Rex", "map1").first;
+        const auto token = *application::Token::FromHex(token_hex);
+
+        tcp::acceptor acceptor{ioc, {net::ip::make_address("127.0.0.1"), 0}};
+        net::io_context client_ioc;
+
+        // Подключает клиента и запускает для него сессию сервера
+        auto connect = [&](websocket::stream<tcp::socket>& ws) {
+            ws.next_layer().connect(acceptor.local_endpoint());
+            std::make_shared<http_server::Session<UpgradeHandler>>(acceptor.accept(net::make_strand(ioc)), UpgradeHandler{api},
+                                                                   "127.0.0.1"s)->Run();
+        };
+
+        auto read_frame = [](websocket::stream<tcp::socket>& ws, http_server::beast::error_code& ec) {
+            http_server::beast::flat_buffer buffer;
+            ws.read(buffer, ec);
+            return http_server::beast::buffers_to_string(buffer.data());
+        };
+
+        auto current_body = [&app, &token] {
+            auto state = app.GetState(token);
+            REQUIRE(state.session_);
+            return *http_handler::MakeStateBody(*state.session_);
+        };
+
+        websocket::stream<tcp::socket> ws{client_ioc};
+        connect(ws);
+        std::thread server{[&ioc] { ioc.run(); }};
+
+        WHEN("the player subscribes with the token parameter") {
+            websocket::response_type response;
+            http_server::beast::error_code ec;
+            ws.handshake(response, "127.0.0.1", "/api/v1/game/state?token=" + token_hex, ec);
+            REQUIRE(!ec);
+
+            THEN("the current state arrives at once and after every tick") {
+                CHECK(read_frame(ws, ec) == current_body());
+                REQUIRE(!ec);
+
+                app.UpdateGameState(100ms);
+                CHECK(read_frame(ws, ec) == current_body());
+                REQUIRE(!ec);
+            }
+
+            THEN("the connection is closed once the player retires") {
+                read_frame(ws, ec);
+                REQUIRE(!ec);
+
+                app.UpdateGameState(2000ms);
+                REQUIRE(records.GetAll().size() == 1);
+
+                read_frame(ws, ec);
+                CHECK(ec == websocket::error::closed);
+            }
+        }
+
+        WHEN("the player subscribes with the Authorization header") {
+            ws.set_option(websocket::stream_base::decorator([&token_hex](websocket::request_type& req) {
+                req.set(http::field::authorization, "Bearer " + token_hex);
+            }));
+
+            websocket::response_type response;
+            http_server::beast::error_code ec;
+            ws.handshake(response, "127.0.0.1", "/api/v1/game/state", ec);
+            REQUIRE(!ec);
+
+            THEN("the current state arrives") {
+                CHECK(read_frame(ws, ec) == current_body());
+            }
+        }
+
+        WHEN("an unknown token is used") {
+            const application::Token unknown{token.GetHi() ^ 1, token.GetLo()};
+
+            // Синхронный handshake заполняет ответ только при успехе, поэтому отказ читается асинхронно
+            websocket::response_type response;
+            http_server::beast::error_code ec;
+            ws.async_handshake(response, "127.0.0.1", "/api/v1/game/state?token=" + unknown.ToHex(),
+                               [&ec](http_server::beast::error_code handshake_ec) {
+                                   ec = handshake_ec;
+                               });
+            client_ioc.run();
+
+            THEN("the upgrade is refused") {
+                CHECK(ec == websocket::error::upgrade_declined);
+                CHECK(response.result() == http::status::unauthorized);
+            }
+        }
+
+        // Сессии сервера завершаются, когда клиент закрывает соединение
+        http_server::beast::error_code ec;
+        ws.next_layer().shutdown(tcp::socket::shutdown_both, ec);
+        ws.next_layer().close(ec);
+        server.join();
+    }
+}